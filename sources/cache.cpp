@@ -0,0 +1,255 @@
+// Copyright 2022-present Contributors to the jobman project.
+// SPDX-License-Identifier: BSD-3-Clause
+// https://github.com/mikaelsundell/jobman
+
+#include "cache.h"
+#include "platform.h"
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QMutex>
+#include <QPointer>
+#include <QRegularExpression>
+#include <QSettings>
+#include <QStandardPaths>
+
+#include <algorithm>
+#include <atomic>
+
+class CachePrivate : public QObject {
+    Q_OBJECT
+public:
+    CachePrivate();
+    void init();
+    void scan();
+    void evict();
+    bool link(const QString& source, const QString& target);
+
+public:
+    struct Entry {
+        qint64 size;
+        QDateTime used;
+    };
+    QString path;
+    QHash<QString, Entry> entries;
+    qint64 size;
+    qint64 maximum;
+    bool scanned;
+    std::atomic<quint64> hits;
+    std::atomic<quint64> misses;
+    mutable QMutex mutex;  // guards entries and size, never held while copying files
+    QPointer<Cache> object;
+};
+
+CachePrivate::CachePrivate()
+    : size(0)
+    , maximum(8LL * 1024 * 1024 * 1024)
+    , scanned(false)
+    , hits(0)
+    , misses(0)
+{}
+
+void
+CachePrivate::init()
+{
+    path = QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation) + "/Cache";
+    QSettings settings(APP_IDENTIFIER, APP_NAME);
+    maximum = settings.value("cachesize", maximum).toLongLong();  // in bytes
+}
+
+void
+CachePrivate::scan()
+{
+    if (scanned) {
+        return;  // called with mutex held, the directory is the index
+    }
+    scanned = true;
+    static const QRegularExpression name("^[0-9a-f]{64}$");
+    QDir dir(path);
+    for (const QFileInfo& fileinfo : dir.entryInfoList(QDir::Files)) {
+        if (fileinfo.suffix() == "tmp") {
+            QFile::remove(fileinfo.filePath());  // left behind by an interrupted insert
+            continue;
+        }
+        if (!name.match(fileinfo.fileName()).hasMatch()) {
+            continue;
+        }
+        entries.insert(fileinfo.fileName(), Entry { fileinfo.size(), fileinfo.lastModified() });
+        size += fileinfo.size();
+    }
+    evict();
+}
+
+void
+CachePrivate::evict()
+{
+    while (size > maximum && !entries.isEmpty()) {
+        auto oldest = std::min_element(entries.begin(), entries.end(),
+                                       [](const Entry& a, const Entry& b) { return a.used < b.used; });
+        QFile::remove(QDir(path).filePath(oldest.key()));
+        size -= oldest->size;
+        entries.erase(oldest);
+    }
+}
+
+bool
+CachePrivate::link(const QString& source, const QString& target)
+{
+    // hardlinks are not used, editing the output in place would change the cached file
+    return platform::cloneFile(source, target) || QFile::copy(source, target);
+}
+
+#include "cache.moc"
+
+Cache::Cache(QObject* parent)
+    : QObject(parent)
+    , p(new CachePrivate())
+{
+    p->object = this;
+    p->init();
+}
+
+Cache::~Cache() {}
+
+QString
+Cache::path() const
+{
+    return p->path;
+}
+
+qint64
+Cache::size() const
+{
+    QMutexLocker locker(&p->mutex);
+    return p->size;
+}
+
+qint64
+Cache::maximumSize() const
+{
+    return p->maximum;
+}
+
+quint64
+Cache::hits() const
+{
+    return p->hits;
+}
+
+quint64
+Cache::misses() const
+{
+    return p->misses;
+}
+
+QString
+Cache::key(const QSharedPointer<Job>& job, const QString& command, const QStringList& inputs) const
+{
+    QCryptographicHash hash(QCryptographicHash::Sha256);
+    QFileInfo commandinfo(command);
+    hash.addData(commandinfo.absoluteFilePath().toUtf8());
+    hash.addData(QByteArray::number(commandinfo.size()));
+    hash.addData(QByteArray::number(commandinfo.lastModified().toMSecsSinceEpoch()));
+    // paths are abstracted, the same input saved elsewhere gives the same key
+    QList<QPair<QString, QString>> paths { { job->output(), "%output%" }, { job->dir(), "%dir%" } };
+    for (int i = 0; i < inputs.size(); ++i) {
+        paths.append(qMakePair(inputs[i], QString("%input%1%").arg(i)));
+    }
+    std::sort(paths.begin(), paths.end(), [](const QPair<QString, QString>& a, const QPair<QString, QString>& b) {
+        return a.first.size() > b.first.size();  // longest first, dir is a prefix of output
+    });
+    auto normalize = [&](QString value) {
+        for (const QPair<QString, QString>& path : paths) {
+            if (!path.first.isEmpty()) {
+                value.replace(path.first, path.second);
+            }
+        }
+        return value;
+    };
+    for (const QString& argument : job->arguments()) {
+        hash.addData(normalize(argument).toUtf8());
+        hash.addData(QByteArray(1, '\0'));
+    }
+    hash.addData(normalize(job->startin()).toUtf8());
+    hash.addData(QFileInfo(job->output()).suffix().toUtf8());  // output format is often chosen by suffix
+    QList<QPair<QString, QString>> environmentvars = job->os().environmentvars;
+    std::sort(environmentvars.begin(), environmentvars.end());
+    for (const QPair<QString, QString>& environmentvar : environmentvars) {
+        hash.addData(QString("%1=%2").arg(environmentvar.first).arg(environmentvar.second).toUtf8());
+        hash.addData(QByteArray(1, '\0'));
+    }
+    for (const QString& input : inputs) {
+        QFile file(input);
+        if (!file.open(QIODevice::ReadOnly) || !hash.addData(&file)) {
+            return QString();  // unreadable input, not cacheable
+        }
+    }
+    return QString::fromLatin1(hash.result().toHex());
+}
+
+bool
+Cache::restore(const QString& key, const QString& output)
+{
+    const QString source = QDir(p->path).filePath(key);
+    {
+        QMutexLocker locker(&p->mutex);
+        p->scan();
+        auto it = p->entries.find(key);
+        if (it == p->entries.end()) {
+            p->misses++;
+            return false;
+        }
+        it->used = QDateTime::currentDateTime();
+    }
+    if ((QFile::exists(output) && !QFile::remove(output)) || !p->link(source, output)) {
+        p->misses++;  // evicted while linking or output not writable
+        return false;
+    }
+    QFile file(source);
+    if (file.open(QIODevice::ReadWrite)) {
+        file.setFileTime(QDateTime::currentDateTime(), QFileDevice::FileModificationTime);  // lru order survives restart
+    }
+    p->hits++;
+    return true;
+}
+
+void
+Cache::insert(const QString& key, const QString& output)
+{
+    QFileInfo outputinfo(output);
+    if (!outputinfo.isFile() || outputinfo.size() == 0) {
+        return;
+    }
+    {
+        QMutexLocker locker(&p->mutex);
+        p->scan();
+        if (p->entries.contains(key) || outputinfo.size() > p->maximum) {
+            return;
+        }
+    }
+    QDir dir(p->path);
+    if (!dir.mkpath(".")) {
+        return;
+    }
+    const QString target = dir.filePath(key);
+    const QString temporary
+        = dir.filePath(QString("%1.%2.tmp").arg(key).arg(QUuid::createUuid().toString(QUuid::Id128)));
+    if (!p->link(output, temporary)) {
+        QFile::remove(temporary);
+        return;
+    }
+    if (!QFile::rename(temporary, target)) {
+        QFile::remove(temporary);  // inserted by another job with the same key
+        return;
+    }
+    QMutexLocker locker(&p->mutex);
+    if (!p->entries.contains(key)) {
+        p->entries.insert(key, CachePrivate::Entry { outputinfo.size(), QDateTime::currentDateTime() });
+        p->size += outputinfo.size();
+        p->evict();
+    }
+}
@@ -0,0 +1,29 @@
+// Copyright 2022-present Contributors to the jobman project.
+// SPDX-License-Identifier: BSD-3-Clause
+// https://github.com/mikaelsundell/jobman
+
+#pragma once
+
+#include "job.h"
+
+#include <QObject>
+#include <QSharedPointer>
+
+class CachePrivate;
+class Cache : public QObject {
+    Q_OBJECT
+public:
+    Cache(QObject* parent = nullptr);
+    virtual ~Cache();
+    QString path() const;
+    qint64 size() const;
+    qint64 maximumSize() const;
+    quint64 hits() const;
+    quint64 misses() const;
+    QString key(const QSharedPointer<Job>& job, const QString& command, const QStringList& inputs) const;
+    bool restore(const QString& key, const QString& output);
+    void insert(const QString& key, const QString& output);
+
+private:
+    QScopedPointer<CachePrivate> p;
+};
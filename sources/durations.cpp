@@ -0,0 +1,243 @@
+// Copyright 2022-present Contributors to the jobman project.
+// SPDX-License-Identifier: BSD-3-Clause
+// https://github.com/mikaelsundell/jobman
+
+#include "durations.h"
+
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMutex>
+#include <QPair>
+#include <QPointer>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+#include <algorithm>
+
+class DurationsPrivate : public QObject {
+    Q_OBJECT
+public:
+    enum Model { Recent = 64, Regression = 3 };  // samples kept for percentiles, needed for regression
+    struct Entry {
+        double count = 0.0;  // decayed sums, x in megabytes of input and y in milliseconds
+        double sumx = 0.0;
+        double sumy = 0.0;
+        double sumxx = 0.0;
+        double sumxy = 0.0;
+        double median = 0.0;  // of recent, kept up to date so lookups do not sort
+        QList<qint64> recent;
+    };
+
+public:
+    DurationsPrivate();
+    void init();
+    void load();
+    void save();
+    static double percentile(const Entry& entry, double percentile);
+
+public:
+    QString path;
+    QString filename;
+    QHash<QPair<QString, QString>, Entry> entries;
+    double decay;
+    bool changed;
+    mutable QMutex mutex;  // guards entries and changed, taken last
+    QPointer<Durations> object;
+};
+
+DurationsPrivate::DurationsPrivate()
+    : decay(0.98)
+    , changed(false)
+{}
+
+void
+DurationsPrivate::init()
+{
+    path = QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation);
+    filename = path + "/durations.json";
+    load();
+}
+
+void
+DurationsPrivate::load()
+{
+    QFile file(filename);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return;  // no history yet
+    }
+    const QJsonDocument document = QJsonDocument::fromJson(file.readAll());
+    const QJsonObject presets = document.object();
+    for (auto preset = presets.constBegin(); preset != presets.constEnd(); ++preset) {
+        const QJsonObject tasks = preset.value().toObject();
+        for (auto task = tasks.constBegin(); task != tasks.constEnd(); ++task) {
+            const QJsonObject object = task.value().toObject();
+            Entry entry;
+            entry.count = object["count"].toDouble();
+            entry.sumx = object["sumx"].toDouble();
+            entry.sumy = object["sumy"].toDouble();
+            entry.sumxx = object["sumxx"].toDouble();
+            entry.sumxy = object["sumxy"].toDouble();
+            for (const QJsonValue& value : object["recent"].toArray()) {
+                entry.recent.append(value.toInteger());
+            }
+            if (entry.count > 0.0 && !entry.recent.isEmpty()) {
+                entry.median = percentile(entry, 0.5);
+                entries.insert(qMakePair(preset.key(), task.key()), entry);
+            }
+        }
+    }
+}
+
+void
+DurationsPrivate::save()
+{
+    QJsonObject presets;
+    for (auto it = entries.constBegin(); it != entries.constEnd(); ++it) {
+        const Entry& entry = it.value();
+        QJsonArray recent;
+        for (qint64 milliseconds : entry.recent) {
+            recent.append(milliseconds);
+        }
+        QJsonObject object;
+        object["count"] = entry.count;
+        object["sumx"] = entry.sumx;
+        object["sumy"] = entry.sumy;
+        object["sumxx"] = entry.sumxx;
+        object["sumxy"] = entry.sumxy;
+        object["recent"] = recent;
+        QJsonObject tasks = presets[it.key().first].toObject();
+        tasks[it.key().second] = object;
+        presets[it.key().first] = tasks;
+    }
+    if (!QDir().mkpath(path)) {
+        qWarning() << "Durations: could not create directory:" << path;
+        return;
+    }
+    QSaveFile file(filename);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "Durations: could not open file:" << filename << file.errorString();
+        return;
+    }
+    file.write(QJsonDocument(presets).toJson(QJsonDocument::Compact));
+    file.commit();
+}
+
+double
+DurationsPrivate::percentile(const Entry& entry, double percentile)
+{
+    QList<qint64> sorted = entry.recent;
+    std::sort(sorted.begin(), sorted.end());
+    const int index = qBound(0, static_cast<int>(percentile * (sorted.size() - 1) + 0.5), sorted.size() - 1);
+    return static_cast<double>(sorted[index]);
+}
+
+#include "durations.moc"
+
+Durations::Durations(QObject* parent)
+    : QObject(parent)
+    , p(new DurationsPrivate())
+{
+    p->object = this;
+    p->init();
+}
+
+Durations::~Durations() {}
+
+QString
+Durations::path() const
+{
+    return p->filename;
+}
+
+double
+Durations::expected(const QString& preset, const QString& id, qint64 size) const
+{
+    double intercept = 0.0;
+    double slope = 0.0;
+    if (!coefficients(preset, id, intercept, slope)) {
+        return -1.0;  // never run
+    }
+    return qMax(0.0, intercept + slope * static_cast<double>(size) / (1024.0 * 1024.0));
+}
+
+bool
+Durations::coefficients(const QString& preset, const QString& id, double& intercept, double& slope) const
+{
+    QMutexLocker locker(&p->mutex);  // milliseconds as intercept plus slope times megabytes of input
+    auto it = p->entries.constFind(qMakePair(preset, id));
+    if (it == p->entries.constEnd()) {
+        return false;
+    }
+    const DurationsPrivate::Entry& entry = it.value();
+    if (entry.count >= DurationsPrivate::Regression) {
+        const double meanx = entry.sumx / entry.count;
+        const double meany = entry.sumy / entry.count;
+        const double variance = entry.sumxx / entry.count - meanx * meanx;
+        if (variance > 1e-6) {
+            const double regression = (entry.sumxy / entry.count - meanx * meany) / variance;
+            if (regression >= 0.0) {  // larger inputs never predicted faster
+                intercept = meany - regression * meanx;
+                slope = regression;
+                return true;
+            }
+        }
+    }
+    intercept = entry.median;  // same sized inputs, median is robust to outliers
+    slope = 0.0;
+    return true;
+}
+
+double
+Durations::percentile(const QString& preset, const QString& id, double percentile) const
+{
+    QMutexLocker locker(&p->mutex);
+    auto it = p->entries.constFind(qMakePair(preset, id));
+    if (it == p->entries.constEnd()) {
+        return -1.0;
+    }
+    return DurationsPrivate::percentile(it.value(), qBound(0.0, percentile, 1.0));
+}
+
+int
+Durations::samples(const QString& preset, const QString& id) const
+{
+    QMutexLocker locker(&p->mutex);
+    auto it = p->entries.constFind(qMakePair(preset, id));
+    return it != p->entries.constEnd() ? static_cast<int>(it->recent.size()) : 0;
+}
+
+void
+Durations::update(const QString& preset, const QString& id, qint64 size, qint64 milliseconds)
+{
+    const double x = static_cast<double>(size) / (1024.0 * 1024.0);
+    const double y = static_cast<double>(milliseconds);
+    QMutexLocker locker(&p->mutex);
+    DurationsPrivate::Entry& entry = p->entries[qMakePair(preset, id)];
+    // older samples fade out, the model follows new tool versions and hardware
+    entry.count = entry.count * p->decay + 1.0;
+    entry.sumx = entry.sumx * p->decay + x;
+    entry.sumy = entry.sumy * p->decay + y;
+    entry.sumxx = entry.sumxx * p->decay + x * x;
+    entry.sumxy = entry.sumxy * p->decay + x * y;
+    entry.recent.append(milliseconds);
+    if (entry.recent.size() > DurationsPrivate::Recent) {
+        entry.recent.removeFirst();
+    }
+    entry.median = DurationsPrivate::percentile(entry, 0.5);
+    p->changed = true;
+}
+
+void
+Durations::flush()
+{
+    QMutexLocker locker(&p->mutex);
+    if (p->changed) {
+        p->changed = false;
+        p->save();
+    }
+}
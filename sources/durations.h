@@ -0,0 +1,26 @@
+// Copyright 2022-present Contributors to the jobman project.
+// SPDX-License-Identifier: BSD-3-Clause
+// https://github.com/mikaelsundell/jobman
+
+#pragma once
+
+#include <QObject>
+#include <QScopedPointer>
+
+class DurationsPrivate;
+class Durations : public QObject {
+    Q_OBJECT
+public:
+    Durations(QObject* parent = nullptr);
+    virtual ~Durations();
+    QString path() const;
+    double expected(const QString& preset, const QString& id, qint64 size) const;
+    bool coefficients(const QString& preset, const QString& id, double& intercept, double& slope) const;
+    double percentile(const QString& preset, const QString& id, double percentile) const;
+    int samples(const QString& preset, const QString& id) const;
+    void update(const QString& preset, const QString& id, qint64 size, qint64 milliseconds);
+    void flush();
+
+private:
+    QScopedPointer<DurationsPrivate> p;
+};
@@ -18,34 +18,65 @@ public:
 public:
     QDateTime created;
     QUuid uuid;
-    QUuid dependson;
+    QUuid batch;
+    QList<QUuid> dependson;  // parents that must complete first
     QString id;
     QString filename;
+    QMap<QString, int> groups;
     QString name;
     QString command;
     QString dir;
     QStringList arguments;
     QString output;
+    QString preset;
     QString startin;
     QString log;
+    bool batched;  // command runs in a batched or piped job, the job checks its output
+    bool cache;
     bool exclusive;
+    bool incremental;
+    bool intermediate;  // output is in scratch, removed once dependents completed
+    bool jobserver;  // nested make or ninja borrows slots from the queue
     bool overwrite;
+    bool skipped;  // completed without running, output was up to date
+    int cpuslots;
+    qint64 memory;
+    int attempt;
+    int idletimeout;  // in seconds without output, zero means no timeout
     int pid;
     int priority;
+    int timeout;  // in seconds, zero means no timeout
+    int weight;
     Job::Status status;
     OS os;
     Preprocess preprocess;
     Postprocess postprocess;
+    Retry retry;
+    Pipe pipe;
+    Worker worker;
+    Response response;
     QPointer<Job> job;
     mutable QMutex mutex;
 };
 
 JobPrivate::JobPrivate()
-    : pid(0)
+    : cpuslots(1)
+    , memory(0)
+    , attempt(0)
+    , idletimeout(0)
+    , pid(0)
     , priority(10)
+    , timeout(0)
+    , weight(1)
     , status(Job::Waiting)
+    , batched(false)
+    , cache(false)
     , exclusive(false)
+    , incremental(false)
+    , intermediate(false)
+    , jobserver(false)
     , overwrite(false)
+    , skipped(false)
     , uuid(QUuid::createUuid())
 {
     created = QDateTime::currentDateTime();
@@ -73,6 +104,34 @@ Job::arguments() const
     return p->arguments;
 }
 
+int
+Job::attempt() const
+{
+    QMutexLocker locker(&p->mutex);
+    return p->attempt;
+}
+
+QUuid
+Job::batch() const
+{
+    QMutexLocker locker(&p->mutex);
+    return p->batch;
+}
+
+bool
+Job::batched() const
+{
+    QMutexLocker locker(&p->mutex);
+    return p->batched;
+}
+
+bool
+Job::cache() const
+{
+    QMutexLocker locker(&p->mutex);
+    return p->cache;
+}
+
 QString
 Job::command() const
 {
@@ -80,6 +139,13 @@ Job::command() const
     return p->command;
 }
 
+int
+Job::cpuslots() const
+{
+    QMutexLocker locker(&p->mutex);
+    return p->cpuslots;
+}
+
 QDateTime
 Job::created() const
 {
@@ -87,7 +153,7 @@ Job::created() const
     return p->created;
 }
 
-QUuid
+QList<QUuid>
 Job::dependson() const
 {
     QMutexLocker locker(&p->mutex);
@@ -108,6 +174,13 @@ Job::filename() const
     return p->filename;
 }
 
+QMap<QString, int>
+Job::groups() const
+{
+    QMutexLocker locker(&p->mutex);
+    return p->groups;
+}
+
 QString
 Job::id() const
 {
@@ -115,6 +188,34 @@ Job::id() const
     return p->id;
 }
 
+int
+Job::idletimeout() const
+{
+    QMutexLocker locker(&p->mutex);
+    return p->idletimeout;
+}
+
+bool
+Job::incremental() const
+{
+    QMutexLocker locker(&p->mutex);
+    return p->incremental;
+}
+
+bool
+Job::intermediate() const
+{
+    QMutexLocker locker(&p->mutex);
+    return p->intermediate;
+}
+
+bool
+Job::jobserver() const
+{
+    QMutexLocker locker(&p->mutex);
+    return p->jobserver;
+}
+
 QString
 Job::name() const
 {
@@ -129,6 +230,27 @@ Job::log() const
     return p->log;
 }
 
+QString
+Job::log(qint64 position, qint64 size) const
+{
+    QMutexLocker locker(&p->mutex);
+    return p->log.mid(position, size);
+}
+
+qint64
+Job::logSize() const
+{
+    QMutexLocker locker(&p->mutex);
+    return p->log.size();
+}
+
+qint64
+Job::memory() const
+{
+    QMutexLocker locker(&p->mutex);
+    return p->memory;
+}
+
 QString
 Job::output() const
 {
@@ -165,6 +287,20 @@ Job::priority() const
     return p->priority;
 }
 
+QString
+Job::preset() const
+{
+    QMutexLocker locker(&p->mutex);
+    return p->preset;
+}
+
+bool
+Job::skipped() const
+{
+    QMutexLocker locker(&p->mutex);
+    return p->skipped;
+}
+
 QString
 Job::startin() const
 {
@@ -179,6 +315,13 @@ Job::status() const
     return p->status;
 }
 
+int
+Job::timeout() const
+{
+    QMutexLocker locker(&p->mutex);
+    return p->timeout;
+}
+
 QUuid
 Job::uuid() const
 {
@@ -186,6 +329,13 @@ Job::uuid() const
     return p->uuid;
 }
 
+int
+Job::weight() const
+{
+    QMutexLocker locker(&p->mutex);
+    return p->weight;
+}
+
 OS&
 Job::os()
 {
@@ -207,6 +357,34 @@ Job::postprocess()
     return p->postprocess;
 }
 
+Retry&
+Job::retry()
+{
+    QMutexLocker locker(&p->mutex);
+    return p->retry;
+}
+
+Pipe&
+Job::pipe()
+{
+    QMutexLocker locker(&p->mutex);
+    return p->pipe;
+}
+
+Worker&
+Job::worker()
+{
+    QMutexLocker locker(&p->mutex);
+    return p->worker;
+}
+
+Response&
+Job::response()
+{
+    QMutexLocker locker(&p->mutex);
+    return p->response;
+}
+
 void
 Job::setArguments(const QStringList& arguments)
 {
@@ -217,6 +395,46 @@ Job::setArguments(const QStringList& arguments)
     }
 }
 
+void
+Job::setAttempt(int attempt)
+{
+    QMutexLocker locker(&p->mutex);
+    if (p->attempt != attempt) {
+        p->attempt = attempt;
+        attemptChanged(attempt);
+    }
+}
+
+void
+Job::setBatch(const QUuid& batch)
+{
+    QMutexLocker locker(&p->mutex);
+    if (p->batch != batch) {
+        p->batch = batch;
+        batchChanged(batch);
+    }
+}
+
+void
+Job::setBatched(bool batched)
+{
+    QMutexLocker locker(&p->mutex);
+    if (p->batched != batched) {
+        p->batched = batched;
+        batchedChanged(batched);
+    }
+}
+
+void
+Job::setCache(bool cache)
+{
+    QMutexLocker locker(&p->mutex);
+    if (p->cache != cache) {
+        p->cache = cache;
+        cacheChanged(cache);
+    }
+}
+
 void
 Job::setCommand(const QString& command)
 {
@@ -228,7 +446,27 @@ Job::setCommand(const QString& command)
 }
 
 void
-Job::setDependson(QUuid dependson)
+Job::setCpuslots(int cpuslots)
+{
+    QMutexLocker locker(&p->mutex);
+    if (p->cpuslots != cpuslots) {
+        p->cpuslots = cpuslots;
+        cpuslotsChanged(cpuslots);
+    }
+}
+
+void
+Job::setCreated(const QDateTime& created)
+{
+    QMutexLocker locker(&p->mutex);
+    if (p->created != created) {
+        p->created = created;
+        createdChanged(created);
+    }
+}
+
+void
+Job::setDependson(const QList<QUuid>& dependson)
 {
     QMutexLocker locker(&p->mutex);
     if (p->dependson != dependson) {
@@ -257,6 +495,16 @@ Job::setFilename(const QString& filename)
     }
 }
 
+void
+Job::setGroups(const QMap<QString, int>& groups)
+{
+    QMutexLocker locker(&p->mutex);
+    if (p->groups != groups) {
+        p->groups = groups;
+        groupsChanged(groups);
+    }
+}
+
 void
 Job::setId(const QString& id)
 {
@@ -267,6 +515,46 @@ Job::setId(const QString& id)
     }
 }
 
+void
+Job::setIdletimeout(int idletimeout)
+{
+    QMutexLocker locker(&p->mutex);
+    if (p->idletimeout != idletimeout) {
+        p->idletimeout = idletimeout;
+        idletimeoutChanged(idletimeout);
+    }
+}
+
+void
+Job::setIncremental(bool incremental)
+{
+    QMutexLocker locker(&p->mutex);
+    if (p->incremental != incremental) {
+        p->incremental = incremental;
+        incrementalChanged(incremental);
+    }
+}
+
+void
+Job::setIntermediate(bool intermediate)
+{
+    QMutexLocker locker(&p->mutex);
+    if (p->intermediate != intermediate) {
+        p->intermediate = intermediate;
+        intermediateChanged(intermediate);
+    }
+}
+
+void
+Job::setJobserver(bool jobserver)
+{
+    QMutexLocker locker(&p->mutex);
+    if (p->jobserver != jobserver) {
+        p->jobserver = jobserver;
+        jobserverChanged(jobserver);
+    }
+}
+
 void
 Job::setLog(const QString& log)
 {
@@ -274,6 +562,28 @@ Job::setLog(const QString& log)
     if (p->log != log) {
         p->log = log;
         logChanged(log);
+        logReset();
+    }
+}
+
+void
+Job::appendLog(const QString& log)
+{
+    QMutexLocker locker(&p->mutex);
+    if (!log.isEmpty()) {
+        qint64 position = p->log.size();  // views extend their index from here
+        p->log.append(log);
+        logAppended(position);  // not logChanged, listeners would copy the whole log on every line
+    }
+}
+
+void
+Job::setMemory(qint64 memory)
+{
+    QMutexLocker locker(&p->mutex);
+    if (p->memory != memory) {
+        p->memory = memory;
+        memoryChanged(memory);
     }
 }
 
@@ -337,6 +647,26 @@ Job::setPriority(int priority)
     }
 }
 
+void
+Job::setPreset(const QString& preset)
+{
+    QMutexLocker locker(&p->mutex);
+    if (p->preset != preset) {
+        p->preset = preset;
+        presetChanged(preset);
+    }
+}
+
+void
+Job::setSkipped(bool skipped)
+{
+    QMutexLocker locker(&p->mutex);
+    if (p->skipped != skipped) {
+        p->skipped = skipped;
+        skippedChanged(skipped);
+    }
+}
+
 void
 Job::setStartin(const QString& startin)
 {
@@ -356,3 +686,33 @@ Job::setStatus(Status status)
         statusChanged(status);
     }
 }
+
+void
+Job::setTimeout(int timeout)
+{
+    QMutexLocker locker(&p->mutex);
+    if (p->timeout != timeout) {
+        p->timeout = timeout;
+        timeoutChanged(timeout);
+    }
+}
+
+void
+Job::setUuid(const QUuid& uuid)
+{
+    QMutexLocker locker(&p->mutex);
+    if (p->uuid != uuid) {
+        p->uuid = uuid;
+        uuidChanged(uuid);
+    }
+}
+
+void
+Job::setWeight(int weight)
+{
+    QMutexLocker locker(&p->mutex);
+    if (p->weight != weight) {
+        p->weight = weight;
+        weightChanged(weight);
+    }
+}
@@ -5,8 +5,10 @@
 #pragma once
 
 #include <QList>
+#include <QMap>
 #include <QObject>
 #include <QPair>
+#include <QRegularExpression>
 #include <QScopedPointer>
 #include <QString>
 #include <QUuid>
@@ -26,6 +28,34 @@ struct Preprocess {
 
 struct Postprocess : public QObject {};
 
+struct Retry {
+    int attempts = 1;  // total attempts, one means no retry
+    double delay = 1.0;  // in seconds, doubled per attempt
+    double maxdelay = 60.0;
+    QList<int> exitcodes;
+    QList<int> signalcodes;
+    QRegularExpression patterns;  // stderr patterns combined and compiled once per task
+    bool valid() const { return attempts > 1; }
+};
+
+struct Pipe {
+    QString command;  // reads the output of the job command, both run in the job's slots
+    QStringList arguments;
+    bool valid() const { return !command.isEmpty(); }
+};
+
+struct Worker {
+    int jobs = 0;  // requests per worker process before it is replaced, zero starts a process per job
+    QStringList arguments;  // worker process arguments, requests carry the job arguments
+    bool valid() const { return jobs > 0; }
+};
+
+struct Response {
+    QString filename;  // written before each attempt of a batched command and removed when it finishes
+    QStringList lines;  // varying argument of the batched files, one per line
+    bool valid() const { return !filename.isEmpty(); }
+};
+
 class JobPrivate;
 class Job : public QObject {
     Q_OBJECT
@@ -38,57 +68,115 @@ public:
     Job();
     virtual ~Job();
     QStringList arguments() const;
+    QUuid batch() const;
+    bool batched() const;
+    bool cache() const;
     QString command() const;
+    int cpuslots() const;
     QDateTime created() const;
-    QUuid dependson() const;
+    QList<QUuid> dependson() const;
     QString dir() const;
     QString filename() const;
+    QMap<QString, int> groups() const;
+    int attempt() const;
     QString id() const;
+    int idletimeout() const;
+    bool incremental() const;
+    bool intermediate() const;
+    bool jobserver() const;
     QString name() const;
     QString log() const;
+    QString log(qint64 position, qint64 size) const;
+    qint64 logSize() const;
+    qint64 memory() const;
     QString output() const;
     bool exclusive() const;
     bool overwrite() const;
     int pid() const;
     int priority() const;
+    QString preset() const;
+    bool skipped() const;
     QString startin() const;
     Status status() const;
+    int timeout() const;
     QUuid uuid() const;
+    int weight() const;
     OS& os();
     Preprocess& preprocess();
     Postprocess& postprocess();
+    Retry& retry();
+    Pipe& pipe();
+    Worker& worker();
+    Response& response();
     void setArguments(const QStringList& arguments);
+    void setAttempt(int attempt);
+    void setBatch(const QUuid& batch);
+    void setBatched(bool batched);
+    void setCache(bool cache);
     void setCommand(const QString& command);
-    void setDependson(QUuid dependson);
+    void setCpuslots(int cpuslots);
+    void setCreated(const QDateTime& created);
+    void setDependson(const QList<QUuid>& dependson);
     void setDir(const QString& dir);
     void setFilename(const QString& filename);
+    void setGroups(const QMap<QString, int>& groups);
     void setId(const QString& id);
+    void setIdletimeout(int idletimeout);
+    void setIncremental(bool incremental);
+    void setIntermediate(bool intermediate);
+    void setJobserver(bool jobserver);
     void setLog(const QString& log);
+    void appendLog(const QString& log);
+    void setMemory(qint64 memory);
     void setName(const QString& name);
     void setOutput(const QString& output);
     void setExclusive(bool exclusive);
     void setOverwrite(bool overwrite);
     void setPid(int pid);
     void setPriority(int priority);
+    void setPreset(const QString& preset);
+    void setSkipped(bool skipped);
     void setStartin(const QString& startin);
     void setStatus(Status status);
+    void setTimeout(int timeout);
+    void setUuid(const QUuid& uuid);
+    void setWeight(int weight);
 
 Q_SIGNALS:
     void argumentsChanged(const QStringList& arguments);
+    void attemptChanged(int attempt);
+    void batchChanged(const QUuid& batch);
+    void batchedChanged(bool batched);
+    void cacheChanged(bool cache);
     void commandChanged(const QString& command);
-    void dependsonChanged(QUuid uuid);
+    void cpuslotsChanged(int cpuslots);
+    void createdChanged(const QDateTime& created);
+    void dependsonChanged(const QList<QUuid>& dependson);
     void dirChanged(QString dir);
     void filenameChanged(const QString& filename);
+    void groupsChanged(const QMap<QString, int>& groups);
     void idChanged(const QString& id);
+    void idletimeoutChanged(int idletimeout);
+    void incrementalChanged(bool incremental);
+    void intermediateChanged(bool intermediate);
+    void jobserverChanged(bool jobserver);
     void logChanged(const QString& log);
+    void logAppended(qint64 position);
+    void logReset();
+    void memoryChanged(qint64 memory);
     void nameChanged(const QString& name);
     void outputChanged(const QString& output);
     void exclusiveChanged(bool exclusive);
     void overwriteChanged(bool overwrite);
     void pidChanged(int pid);
     void priorityChanged(int priority);
+    void presetChanged(const QString& preset);
+    void skippedChanged(bool skipped);
     void startinChanged(const QString& startin);
     void statusChanged(Status status);
+    void timeoutChanged(int timeout);
+    void uuidChanged(const QUuid& uuid);
+    void weightChanged(int weight);
 
 private:
     QScopedPointer<JobPrivate> p;
@@ -96,6 +96,7 @@ public Q_SLOTS:
     void overwriteChanged(int state);
     void presetsChanged(int index);
     void threadsChanged(int index);
+    void adaptiveChanged(int state);
     void openAbout();
     void openGithubReadme();
     void openGithubIssues();
@@ -148,6 +149,8 @@ public:
     bool copyoriginal;
     bool createfolders;
     bool overwrite;
+    bool adaptive;
+    int reserved;
     int threads;
     int submitcount;
     qsizetype submittotal;
@@ -243,10 +246,12 @@ JobmanPrivate::init()
     connect(ui->copyOriginal, &QCheckBox::checkStateChanged, this, &JobmanPrivate::copyOriginalChanged);
     connect(ui->createFolders, &QCheckBox::checkStateChanged, this, &JobmanPrivate::createFolderChanged);
     connect(ui->overwrite, &QCheckBox::checkStateChanged, this, &JobmanPrivate::overwriteChanged);
+    connect(ui->adaptive, &QCheckBox::checkStateChanged, this, &JobmanPrivate::adaptiveChanged);
 #else
     connect(ui->copyOriginal, &QCheckBox::stateChanged, this, &JobmanPrivate::copyOriginalChanged);
     connect(ui->createFolders, &QCheckBox::stateChanged, this, &JobmanPrivate::createFolderChanged);
     connect(ui->overwrite, &QCheckBox::stateChanged, this, &JobmanPrivate::overwriteChanged);
+    connect(ui->adaptive, &QCheckBox::stateChanged, this, &JobmanPrivate::adaptiveChanged);
 #endif
     connect(ui->filedrop, &Filedrop::filesDropped, this, &JobmanPrivate::processFiles, Qt::QueuedConnection);
     connect(ui->presets, static_cast<void (QComboBox::*)(int)>(&QComboBox::currentIndexChanged), this,
@@ -273,11 +278,26 @@ JobmanPrivate::init()
         ui->threads->addItem(QString::number(i), i);
     }
     ui->threads->setCurrentIndex(threads);
+    queue->setAdaptiveAsync(adaptive);
+    queue->setReservedAsync(reserved);
+    // journal
+    queue->restoreAsync().then(this, [this](const QList<QUuid>& uuids) {
+        if (uuids.size()) {
+            processUuids(uuids);  // interrupted jobs resumed from the last session
+        }
+    });
     // cpu
     QTimer* timer = new QTimer(window.data());
     QObject::connect(timer, &QTimer::timeout, [&]() {
         if (ui->fileprogress->maximum()) {
-            ui->cpu->setText(QString("CPU: %1%").arg(platform::getCpuUsage(), 0, 'f', 0));
+            const std::shared_ptr<const QueueSnapshot> snapshot = queue->snapshot();
+            QString text = QString("CPU: %1%").arg(snapshot->cpu, 0, 'f', 0);  // sampled by the queue
+            if (snapshot->remaining > 0) {
+                const qint64 minutes = (snapshot->remaining + 59999) / 60000;  // estimated from past runs
+                text += minutes < 60 ? QString(" - ETA: %1 min").arg(minutes)
+                                     : QString(" - ETA: %1 h %2 min").arg(minutes / 60).arg(minutes % 60);
+            }
+            ui->cpu->setText(text);
         }
         else {
             ui->cpu->setText(QString(""));
@@ -628,12 +648,15 @@ JobmanPrivate::loadSettings()
     createfolders = settings.value("createfolders", true).toBool();
     overwrite = settings.value("overwrite", true).toBool();
     threads = settings.value("threads", 0).toInt();
+    adaptive = settings.value("adaptive", false).toBool();
+    reserved = settings.value("reserved", 0).toInt();
     // ui
     setSaveto(saveto);
     ui->copyOriginal->setChecked(copyoriginal);
     ui->createFolders->setChecked(createfolders);
     ui->overwrite->setChecked(overwrite);
     ui->threads->setCurrentIndex(threads);
+    ui->adaptive->setChecked(adaptive);
 }
 
 void
@@ -682,6 +705,8 @@ JobmanPrivate::saveSettings()
         }
     }
     settings.setValue("threads", ui->threads->currentIndex());
+    settings.setValue("adaptive", adaptive);
+    settings.setValue("reserved", reserved);
 }
 
 void
@@ -1209,7 +1234,14 @@ JobmanPrivate::presetsChanged(int index)
 void
 JobmanPrivate::threadsChanged(int index)
 {
-    queue->setThreads(ui->threads->itemText(index).toInt());
+    queue->setThreadsAsync(ui->threads->itemText(index).toInt());
+}
+
+void
+JobmanPrivate::adaptiveChanged(int state)
+{
+    adaptive = (state == Qt::Checked);
+    queue->setAdaptiveAsync(adaptive);  // max threads becomes the upper bound
 }
 
 void
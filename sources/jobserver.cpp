@@ -0,0 +1,187 @@
+// Copyright 2022-present Contributors to the jobman project.
+// SPDX-License-Identifier: BSD-3-Clause
+// https://github.com/mikaelsundell/jobman
+
+#include "jobserver.h"
+
+#ifdef __APPLE__
+#    include <errno.h>
+#    include <fcntl.h>
+#    include <sys/stat.h>
+#    include <unistd.h>
+#endif
+
+#ifdef _WIN32
+#    include <windows.h>
+#endif
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QPointer>
+
+class JobserverPrivate : public QObject {
+    Q_OBJECT
+public:
+    JobserverPrivate();
+    ~JobserverPrivate();
+    void init();
+    int take();
+
+public:
+    QString name;
+    int tokens;  // written and not yet read back, offered or borrowed
+#ifdef __APPLE__
+    int fd;
+#elif defined(_WIN32)
+    HANDLE semaphore;
+#endif
+    QPointer<Jobserver> object;
+};
+
+JobserverPrivate::JobserverPrivate()
+    : tokens(0)
+{
+#ifdef __APPLE__
+    fd = -1;
+#elif defined(_WIN32)
+    semaphore = nullptr;
+#endif
+}
+
+JobserverPrivate::~JobserverPrivate()
+{
+#ifdef __APPLE__
+    if (fd != -1) {
+        close(fd);
+        unlink(name.toLocal8Bit().constData());
+    }
+#elif defined(_WIN32)
+    if (semaphore != nullptr) {
+        CloseHandle(semaphore);
+    }
+#endif
+}
+
+void
+JobserverPrivate::init()
+{
+#ifdef __APPLE__
+    // named fifo as in gnu make 4.4, opened read write so it never reports eof
+    name = QDir::temp().filePath(QString("jobman-%1.fifo").arg(QCoreApplication::applicationPid()));
+    QByteArray path = name.toLocal8Bit();
+    unlink(path.constData());
+    if (mkfifo(path.constData(), 0600) == 0) {
+        fd = open(path.constData(), O_RDWR | O_NONBLOCK | O_CLOEXEC);
+    }
+#elif defined(_WIN32)
+    // named semaphore as in gnu make on windows
+    name = QString("jobman_jobserver_%1").arg(QCoreApplication::applicationPid());
+    semaphore = CreateSemaphoreW(nullptr, 0, 4096, reinterpret_cast<LPCWSTR>(name.utf16()));
+#endif
+}
+
+int
+JobserverPrivate::take()
+{
+    int taken = 0;
+#ifdef __APPLE__
+    char buffer[256];
+    while (fd != -1) {
+        ssize_t bytesread = read(fd, buffer, sizeof(buffer));
+        if (bytesread > 0) {
+            taken += bytesread;
+        }
+        else if (bytesread < 0 && errno == EINTR) {
+            continue;
+        }
+        else {
+            break;  // empty, EAGAIN
+        }
+    }
+#elif defined(_WIN32)
+    while (semaphore != nullptr && WaitForSingleObject(semaphore, 0) == WAIT_OBJECT_0) {
+        taken++;
+    }
+#endif
+    return taken;
+}
+
+#include "jobserver.moc"
+
+Jobserver::Jobserver(QObject* parent)
+    : QObject(parent)
+    , p(new JobserverPrivate())
+{
+    p->object = this;
+    p->init();
+}
+
+Jobserver::~Jobserver() {}
+
+bool
+Jobserver::isValid() const
+{
+#ifdef __APPLE__
+    return p->fd != -1;
+#elif defined(_WIN32)
+    return p->semaphore != nullptr;
+#endif
+}
+
+QString
+Jobserver::makeflags(int jobs) const
+{
+#ifdef __APPLE__
+    return QString("-j%1 --jobserver-auth=fifo:%2").arg(jobs).arg(p->name);
+#elif defined(_WIN32)
+    return QString("-j%1 --jobserver-auth=%2").arg(jobs).arg(p->name);
+#endif
+}
+
+int
+Jobserver::lent() const
+{
+    return p->tokens;
+}
+
+int
+Jobserver::reclaim()
+{
+    // unused tokens come back, the rest are held by running tools
+    p->tokens = qMax(0, p->tokens - p->take());
+    return p->tokens;
+}
+
+void
+Jobserver::lend(int tokens)
+{
+    if (tokens <= 0) {
+        return;
+    }
+#ifdef __APPLE__
+    QByteArray buffer(tokens, '+');
+    ssize_t written = 0;
+    while (p->fd != -1 && written < buffer.size()) {
+        ssize_t bytes = write(p->fd, buffer.constData() + written, buffer.size() - written);
+        if (bytes < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+        written += bytes;
+    }
+    p->tokens += static_cast<int>(written);
+#elif defined(_WIN32)
+    if (p->semaphore != nullptr && ReleaseSemaphore(p->semaphore, tokens, nullptr)) {
+        p->tokens += tokens;
+    }
+#endif
+}
+
+void
+Jobserver::clear()
+{
+    p->take();
+    p->tokens = 0;  // tokens of tools that exited without returning them are lost with the tool
+}
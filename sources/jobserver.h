@@ -0,0 +1,24 @@
+// Copyright 2022-present Contributors to the jobman project.
+// SPDX-License-Identifier: BSD-3-Clause
+// https://github.com/mikaelsundell/jobman
+
+#pragma once
+
+#include <QObject>
+
+class JobserverPrivate;
+class Jobserver : public QObject {
+    Q_OBJECT
+public:
+    Jobserver(QObject* parent = nullptr);
+    virtual ~Jobserver();
+    bool isValid() const;
+    QString makeflags(int jobs) const;
+    int lent() const;
+    int reclaim();
+    void lend(int tokens);
+    void clear();
+
+private:
+    QScopedPointer<JobserverPrivate> p;
+};
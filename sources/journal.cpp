@@ -0,0 +1,509 @@
+// Copyright 2022-present Contributors to the jobman project.
+// SPDX-License-Identifier: BSD-3-Clause
+// https://github.com/mikaelsundell/jobman
+
+#include "journal.h"
+
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMutex>
+#include <QPointer>
+#include <QSaveFile>
+#include <QSet>
+#include <QStandardPaths>
+
+#include <algorithm>
+
+#ifdef Q_OS_WIN
+#    include <io.h>
+#else
+#    include <unistd.h>
+#endif
+
+class JournalPrivate : public QObject {
+    Q_OBJECT
+public:
+    enum Compact { Records = 10000 };  // records appended before the journal is folded into a snapshot
+
+public:
+    JournalPrivate();
+    void init();
+    bool open();
+    void append(const QJsonObject& record);
+    void load(const QString& filename, QHash<QUuid, QJsonObject>& jobs);
+    void compact();
+    static void apply(QHash<QUuid, QJsonObject>& jobs, const QJsonObject& record);
+    static void sync(QFileDevice& file);
+    static QJsonObject writeJob(const QSharedPointer<Job>& job);
+    static QSharedPointer<Job> readJob(const QJsonObject& object);
+
+public:
+    QString path;
+    QString journalname;
+    QString snapshotname;
+    QFile file;
+    QByteArray pending;
+    QHash<QUuid, QJsonObject> jobs;
+    QHash<QUuid, QJsonObject> finished;  // finished batches left out of snapshots, revived when changed
+    int records;
+    bool closed;
+    QMutex mutex;      // guards pending, jobs and records, taken from any thread changing a job
+    QMutex filemutex;  // guards file, held while writing to disk, never taken while holding mutex
+    QPointer<Journal> object;
+};
+
+JournalPrivate::JournalPrivate()
+    : records(0)
+    , closed(false)
+{}
+
+void
+JournalPrivate::init()
+{
+    path = QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation) + "/Journal";
+    journalname = path + "/queue.journal";
+    snapshotname = path + "/queue.snapshot";
+}
+
+bool
+JournalPrivate::open()
+{
+    if (file.isOpen()) {
+        return true;
+    }
+    if (!QDir().mkpath(path)) {
+        qWarning() << "Journal: could not create directory:" << path;
+        return false;
+    }
+    file.setFileName(journalname);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Append)) {
+        qWarning() << "Journal: could not open file:" << journalname << file.errorString();
+        return false;
+    }
+    return true;
+}
+
+void
+JournalPrivate::append(const QJsonObject& record)
+{
+    QMutexLocker locker(&mutex);
+    if (closed) {
+        return;
+    }
+    QJsonObject entry = record;
+    auto it = finished.find(QUuid(record["uuid"].toString()));
+    if (it != finished.end()) {
+        if (record["type"].toString() == "remove") {
+            finished.erase(it);  // not in the snapshot, nothing to record
+            return;
+        }
+        jobs.insert(it.key(), it.value());  // restarted or changed, needs its submit record again
+        apply(jobs, record);
+        entry = QJsonObject { { "type", "submit" }, { "job", jobs.value(it.key()) } };
+        finished.erase(it);
+    }
+    else {
+        apply(jobs, record);
+    }
+    pending.append(QJsonDocument(entry).toJson(QJsonDocument::Compact));
+    pending.append('\n');
+    records++;
+}
+
+void
+JournalPrivate::load(const QString& filename, QHash<QUuid, QJsonObject>& jobs)
+{
+    QFile input(filename);
+    if (!input.open(QIODevice::ReadOnly)) {
+        return;
+    }
+    while (!input.atEnd()) {
+        const QByteArray line = input.readLine().trimmed();
+        if (line.isEmpty()) {
+            continue;
+        }
+        QJsonParseError error;
+        const QJsonDocument document = QJsonDocument::fromJson(line, &error);
+        if (error.error != QJsonParseError::NoError || !document.isObject()) {
+            qWarning() << "Journal: skipped unreadable record in:" << filename;  // torn write at crash
+            continue;
+        }
+        apply(jobs, document.object());
+    }
+}
+
+void
+JournalPrivate::compact()
+{
+    QByteArray data;  // called with filemutex held
+    {
+        QMutexLocker locker(&mutex);
+        QSet<QString> batches;
+        for (const QJsonObject& job : jobs) {
+            const Job::Status status = static_cast<Job::Status>(job["status"].toInt());
+            if (status == Job::Waiting || status == Job::Running) {
+                batches.insert(job["batch"].toString());
+            }
+        }
+        for (auto it = jobs.begin(); it != jobs.end();) {
+            if (!batches.contains(it.value()["batch"].toString())) {
+                finished.insert(it.key(), it.value());  // nothing left to resume, restore drops them too
+                it = jobs.erase(it);
+            }
+            else {
+                ++it;
+            }
+        }
+        for (const QJsonObject& job : jobs) {
+            data.append(QJsonDocument(QJsonObject { { "type", "submit" }, { "job", job } })
+                            .toJson(QJsonDocument::Compact));
+            data.append('\n');
+        }
+        pending.clear();  // folded into the snapshot
+        records = 0;
+    }
+    if (!open()) {
+        return;
+    }
+    QSaveFile snapshot(snapshotname);
+    if (!snapshot.open(QIODevice::WriteOnly)) {
+        qWarning() << "Journal: could not write snapshot:" << snapshotname << snapshot.errorString();
+        return;
+    }
+    snapshot.write(data);
+    sync(snapshot);
+    if (!snapshot.commit()) {
+        qWarning() << "Journal: could not commit snapshot:" << snapshotname << snapshot.errorString();
+        return;
+    }
+    file.resize(0);  // snapshot replaced atomically, replaying stale records on top of it is harmless
+    sync(file);
+}
+
+void
+JournalPrivate::apply(QHash<QUuid, QJsonObject>& jobs, const QJsonObject& record)
+{
+    const QString type = record["type"].toString();
+    if (type == "submit") {
+        const QJsonObject job = record["job"].toObject();
+        jobs.insert(QUuid(job["uuid"].toString()), job);
+        return;
+    }
+    const QUuid uuid(record["uuid"].toString());
+    auto it = jobs.find(uuid);
+    if (it == jobs.end()) {
+        return;
+    }
+    if (type == "status") {
+        (*it)["status"] = record["status"];
+    }
+    else if (type == "priority") {
+        (*it)["priority"] = record["priority"];
+    }
+    else if (type == "remove") {
+        jobs.erase(it);
+    }
+}
+
+void
+JournalPrivate::sync(QFileDevice& file)
+{
+    file.flush();
+#ifdef Q_OS_WIN
+    _commit(file.handle());
+#else
+    fsync(file.handle());
+#endif
+}
+
+QJsonObject
+JournalPrivate::writeJob(const QSharedPointer<Job>& job)
+{
+    QJsonObject object;
+    object["uuid"] = job->uuid().toString();
+    object["batch"] = job->batch().toString();
+    object["created"] = job->created().toString(Qt::ISODateWithMs);
+    QJsonArray dependson;
+    for (const QUuid& uuid : job->dependson()) {
+        dependson.append(uuid.toString());
+    }
+    object["dependson"] = dependson;
+    object["id"] = job->id();
+    object["preset"] = job->preset();
+    object["filename"] = job->filename();
+    object["name"] = job->name();
+    object["command"] = job->command();
+    object["arguments"] = QJsonArray::fromStringList(job->arguments());
+    object["output"] = job->output();
+    object["dir"] = job->dir();
+    object["startin"] = job->startin();
+    object["exclusive"] = job->exclusive();
+    object["overwrite"] = job->overwrite();
+    object["skipped"] = job->skipped();
+    object["incremental"] = job->incremental();
+    object["cache"] = job->cache();
+    object["cpuslots"] = job->cpuslots();
+    object["memory"] = job->memory();
+    QJsonObject groups;
+    const QMap<QString, int> jobgroups = job->groups();
+    for (auto it = jobgroups.cbegin(); it != jobgroups.cend(); ++it) {
+        groups[it.key()] = it.value();
+    }
+    object["groups"] = groups;
+    object["priority"] = job->priority();
+    object["weight"] = job->weight();
+    object["status"] = job->status();
+    object["searchpaths"] = QJsonArray::fromStringList(job->os().searchpaths);
+    QJsonArray environmentvars;
+    for (const QPair<QString, QString>& environmentvar : job->os().environmentvars) {
+        environmentvars.append(QJsonObject { { "name", environmentvar.first }, { "value", environmentvar.second } });
+    }
+    object["environmentvars"] = environmentvars;
+    object["copyoriginal"] = job->preprocess().copyoriginal.filename;
+    const Retry retry = job->retry();
+    QJsonArray exitcodes;
+    for (int exitcode : retry.exitcodes) {
+        exitcodes.append(exitcode);
+    }
+    QJsonArray signalcodes;
+    for (int signalcode : retry.signalcodes) {
+        signalcodes.append(signalcode);
+    }
+    QJsonObject jobretry;
+    jobretry["attempts"] = retry.attempts;
+    jobretry["delay"] = retry.delay;
+    jobretry["maxdelay"] = retry.maxdelay;
+    jobretry["exitcodes"] = exitcodes;
+    jobretry["signals"] = signalcodes;
+    jobretry["patterns"] = retry.patterns.pattern();
+    object["retry"] = jobretry;
+    const Pipe pipe = job->pipe();
+    if (pipe.valid()) {
+        object["pipe"] = QJsonObject { { "command", pipe.command },
+                                       { "arguments", QJsonArray::fromStringList(pipe.arguments) } };
+    }
+    const Worker worker = job->worker();
+    if (worker.valid()) {
+        object["worker"] = QJsonObject { { "jobs", worker.jobs },
+                                         { "arguments", QJsonArray::fromStringList(worker.arguments) } };
+    }
+    const Response response = job->response();
+    if (response.valid()) {
+        object["response"] = QJsonObject { { "filename", response.filename },
+                                           { "lines", QJsonArray::fromStringList(response.lines) } };
+    }
+    object["attempt"] = job->attempt();
+    object["timeout"] = job->timeout();
+    object["batched"] = job->batched();
+    object["intermediate"] = job->intermediate();
+    object["jobserver"] = job->jobserver();
+    object["idletimeout"] = job->idletimeout();
+    return object;
+}
+
+QSharedPointer<Job>
+JournalPrivate::readJob(const QJsonObject& object)
+{
+    QSharedPointer<Job> job(new Job());
+    job->setUuid(QUuid(object["uuid"].toString()));
+    job->setBatch(QUuid(object["batch"].toString()));
+    job->setCreated(QDateTime::fromString(object["created"].toString(), Qt::ISODateWithMs));
+    QList<QUuid> dependson;
+    if (object["dependson"].isArray()) {
+        for (const QJsonValue& uuid : object["dependson"].toArray()) {
+            dependson.append(QUuid(uuid.toString()));
+        }
+    }
+    else if (!QUuid(object["dependson"].toString()).isNull()) {
+        dependson.append(QUuid(object["dependson"].toString()));  // written before fan-in
+    }
+    job->setDependson(dependson);
+    job->setId(object["id"].toString());
+    job->setPreset(object["preset"].toString());
+    job->setFilename(object["filename"].toString());
+    job->setName(object["name"].toString());
+    job->setCommand(object["command"].toString());
+    QStringList arguments;
+    for (const QJsonValue& argument : object["arguments"].toArray()) {
+        arguments.append(argument.toString());
+    }
+    job->setArguments(arguments);
+    job->setOutput(object["output"].toString());
+    job->setDir(object["dir"].toString());
+    job->setStartin(object["startin"].toString());
+    job->setExclusive(object["exclusive"].toBool());
+    job->setOverwrite(object["overwrite"].toBool());
+    job->setSkipped(object["skipped"].toBool());
+    job->setIncremental(object["incremental"].toBool());
+    job->setCache(object["cache"].toBool());
+    job->setCpuslots(object["cpuslots"].toInt(1));
+    job->setMemory(object["memory"].toInteger());
+    QMap<QString, int> groups;
+    const QJsonObject jobgroups = object["groups"].toObject();
+    for (auto it = jobgroups.constBegin(); it != jobgroups.constEnd(); ++it) {
+        groups.insert(it.key(), it.value().toInt(1));
+    }
+    job->setGroups(groups);
+    job->setPriority(object["priority"].toInt(10));
+    job->setWeight(object["weight"].toInt(1));
+    job->setStatus(static_cast<Job::Status>(object["status"].toInt()));
+    for (const QJsonValue& searchpath : object["searchpaths"].toArray()) {
+        job->os().searchpaths.append(searchpath.toString());
+    }
+    for (const QJsonValue& environmentvar : object["environmentvars"].toArray()) {
+        const QJsonObject variable = environmentvar.toObject();
+        job->os().environmentvars.append(qMakePair(variable["name"].toString(), variable["value"].toString()));
+    }
+    job->preprocess().copyoriginal.filename = object["copyoriginal"].toString();
+    const QJsonObject retry = object["retry"].toObject();
+    job->retry().attempts = retry["attempts"].toInt(1);
+    job->retry().delay = retry["delay"].toDouble(1.0);
+    job->retry().maxdelay = retry["maxdelay"].toDouble(60.0);
+    for (const QJsonValue& exitcode : retry["exitcodes"].toArray()) {
+        job->retry().exitcodes.append(exitcode.toInt());
+    }
+    for (const QJsonValue& signalcode : retry["signals"].toArray()) {
+        job->retry().signalcodes.append(signalcode.toInt());
+    }
+    if (!retry["patterns"].toString().isEmpty()) {
+        job->retry().patterns = QRegularExpression(retry["patterns"].toString());
+    }
+    const QJsonObject pipe = object["pipe"].toObject();
+    job->pipe().command = pipe["command"].toString();
+    for (const QJsonValue& argument : pipe["arguments"].toArray()) {
+        job->pipe().arguments.append(argument.toString());
+    }
+    const QJsonObject worker = object["worker"].toObject();
+    job->worker().jobs = worker["jobs"].toInt();
+    for (const QJsonValue& argument : worker["arguments"].toArray()) {
+        job->worker().arguments.append(argument.toString());
+    }
+    const QJsonObject response = object["response"].toObject();
+    job->response().filename = response["filename"].toString();
+    for (const QJsonValue& line : response["lines"].toArray()) {
+        job->response().lines.append(line.toString());
+    }
+    job->setAttempt(object["attempt"].toInt());
+    job->setTimeout(object["timeout"].toInt());
+    job->setBatched(object["batched"].toBool());
+    job->setIntermediate(object["intermediate"].toBool());
+    job->setJobserver(object["jobserver"].toBool());
+    job->setIdletimeout(object["idletimeout"].toInt());
+    return job;
+}
+
+#include "journal.moc"
+
+Journal::Journal(QObject* parent)
+    : QObject(parent)
+    , p(new JournalPrivate())
+{
+    p->object = this;
+    p->init();
+}
+
+Journal::~Journal() {}
+
+QString
+Journal::path() const
+{
+    return p->path;
+}
+
+QList<QSharedPointer<Job>>
+Journal::restore()
+{
+    QMutexLocker filelocker(&p->filemutex);
+    QHash<QUuid, QJsonObject> restored;
+    p->load(p->snapshotname, restored);
+    p->load(p->journalname, restored);  // replayed on top of the last snapshot
+    QSet<QUuid> batches;
+    for (const QJsonObject& object : restored) {
+        const Job::Status status = static_cast<Job::Status>(object["status"].toInt());
+        if (status == Job::Waiting || status == Job::Running) {
+            batches.insert(QUuid(object["batch"].toString()));  // null batch groups standalone jobs
+        }
+    }
+    QList<QSharedPointer<Job>> jobs;
+    {
+        QMutexLocker locker(&p->mutex);
+        for (auto it = restored.begin(); it != restored.end(); ++it) {
+            if (p->jobs.contains(it.key()) || !batches.contains(QUuid(it.value()["batch"].toString()))) {
+                continue;  // finished batches are dropped, nothing left to resume
+            }
+            QJsonObject& object = it.value();
+            if (object["status"].toInt() == Job::Running) {
+                object["status"] = Job::Waiting;  // interrupted, requeued
+            }
+            p->jobs.insert(it.key(), object);
+            jobs.append(JournalPrivate::readJob(object));
+        }
+    }
+    std::sort(jobs.begin(), jobs.end(), [](const QSharedPointer<Job>& a, const QSharedPointer<Job>& b) {
+        return a->created() < b->created();  // parents before dependents
+    });
+    p->compact();
+    return jobs;
+}
+
+void
+Journal::submitted(const QSharedPointer<Job>& job)
+{
+    p->append(QJsonObject { { "type", "submit" }, { "job", JournalPrivate::writeJob(job) } });
+}
+
+void
+Journal::statusChanged(const QUuid& uuid, Job::Status status)
+{
+    p->append(QJsonObject { { "type", "status" }, { "uuid", uuid.toString() }, { "status", status } });
+}
+
+void
+Journal::priorityChanged(const QUuid& uuid, int priority)
+{
+    p->append(QJsonObject { { "type", "priority" }, { "uuid", uuid.toString() }, { "priority", priority } });
+}
+
+void
+Journal::removed(const QUuid& uuid)
+{
+    p->append(QJsonObject { { "type", "remove" }, { "uuid", uuid.toString() } });
+}
+
+void
+Journal::flush()
+{
+    QMutexLocker filelocker(&p->filemutex);
+    QByteArray data;
+    bool compact = false;
+    {
+        QMutexLocker locker(&p->mutex);
+        if (p->pending.isEmpty()) {
+            return;
+        }
+        compact = p->records > qMax<qsizetype>(JournalPrivate::Records, p->jobs.size() * 2);
+        if (!compact) {
+            data.swap(p->pending);
+        }
+    }
+    if (compact) {
+        p->compact();
+    }
+    else if (p->open()) {
+        p->file.write(data);
+        JournalPrivate::sync(p->file);  // one fsync per flush, not per record
+    }
+}
+
+void
+Journal::close()
+{
+    flush();
+    QMutexLocker locker(&p->mutex);
+    p->closed = true;  // jobs killed at exit are resumed, not recorded as stopped
+}
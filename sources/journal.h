@@ -0,0 +1,29 @@
+// Copyright 2022-present Contributors to the jobman project.
+// SPDX-License-Identifier: BSD-3-Clause
+// https://github.com/mikaelsundell/jobman
+
+#pragma once
+
+#include "job.h"
+
+#include <QObject>
+#include <QSharedPointer>
+
+class JournalPrivate;
+class Journal : public QObject {
+    Q_OBJECT
+public:
+    Journal(QObject* parent = nullptr);
+    virtual ~Journal();
+    QString path() const;
+    QList<QSharedPointer<Job>> restore();
+    void submitted(const QSharedPointer<Job>& job);
+    void statusChanged(const QUuid& uuid, Job::Status status);
+    void priorityChanged(const QUuid& uuid, int priority);
+    void removed(const QUuid& uuid);
+    void flush();
+    void close();
+
+private:
+    QScopedPointer<JournalPrivate> p;
+};
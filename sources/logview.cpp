@@ -0,0 +1,537 @@
+// Copyright 2022-present Contributors to the jobman project.
+// SPDX-License-Identifier: BSD-3-Clause
+// https://github.com/mikaelsundell/jobman
+
+#include "logview.h"
+
+#include <QCache>
+#include <QClipboard>
+#include <QContextMenuEvent>
+#include <QGuiApplication>
+#include <QKeyEvent>
+#include <QMenu>
+#include <QMouseEvent>
+#include <QPainter>
+#include <QPointer>
+#include <QScrollBar>
+#include <QTimer>
+
+class LogViewPrivate : public QObject {
+    Q_OBJECT
+public:
+    enum Size { PageSize = 64 * 1024, IndexSize = 4 * 1024 * 1024, LineSize = 4096, Margin = 4 };  // in characters
+
+    struct Cursor {
+        qint64 line = 0;
+        int column = 0;
+        bool operator<(const Cursor& other) const
+        {
+            return line < other.line || (line == other.line && column < other.column);
+        }
+        bool operator==(const Cursor& other) const { return line == other.line && column == other.column; }
+    };
+
+public:
+    LogViewPrivate();
+    void init();
+    void reset();
+    void index();
+    void updateScrollBars();
+    qint64 size() const;
+    qint64 lineCount() const;
+    QString source(qint64 position, qint64 size) const;
+    QString page(qint64 index);
+    QString read(qint64 position, qint64 size);
+    QString line(qint64 index);
+    QStringList tail(int count);
+    Cursor cursorAt(const QPoint& point);
+    bool selected(qint64 index, int size, int& from, int& to) const;
+
+public Q_SLOTS:
+    void logAppended(qint64 position);
+    void logReset();
+
+public:
+    QSharedPointer<Job> job;
+    QString text;
+    QList<qint64> lines;
+    qint64 indexed;
+    qint64 total;
+    int width;
+    bool follow;
+    bool updating;
+    Cursor anchor;  // selection in displayed lines, empty when equal to cursor
+    Cursor cursor;
+    QTimer indexer;
+    QCache<qint64, QString> pages;
+    QMetaObject::Connection appended;
+    QMetaObject::Connection resetted;
+    QPointer<LogView> widget;
+};
+
+LogViewPrivate::LogViewPrivate()
+    : indexed(0)
+    , total(0)
+    , width(0)
+    , follow(false)
+    , updating(false)
+{
+    lines.append(0);
+}
+
+void
+LogViewPrivate::init()
+{
+    pages.setMaxCost(64);  // pages kept in memory, each PageSize characters
+    indexer.setSingleShot(true);
+    indexer.setInterval(0);
+    widget->setFocusPolicy(Qt::StrongFocus);  // copy and select all shortcuts
+    widget->viewport()->setCursor(Qt::IBeamCursor);
+    // connect
+    connect(&indexer, &QTimer::timeout, this, &LogViewPrivate::index);
+}
+
+void
+LogViewPrivate::reset()
+{
+    indexer.stop();
+    pages.clear();
+    lines.clear();
+    lines.append(0);
+    indexed = 0;
+    total = size();
+    anchor = cursor = Cursor();
+    width = 0;
+    widget->horizontalScrollBar()->setValue(0);
+    index();
+}
+
+void
+LogViewPrivate::index()
+{
+    qint64 end = qMin<qint64>(indexed + IndexSize, total);
+    if (indexed < end) {
+        QString data = source(indexed, end - indexed);  // scanned in chunks, never the whole log at once
+        qsizetype from = 0;
+        while ((from = data.indexOf(QLatin1Char('\n'), from)) != -1) {
+            lines.append(indexed + from + 1);
+            from++;
+        }
+        indexed += data.size();
+    }
+    if (indexed < total) {
+        indexer.start();
+    }
+    updateScrollBars();
+    widget->viewport()->update();
+}
+
+void
+LogViewPrivate::updateScrollBars()
+{
+    updating = true;
+    QFontMetrics metrics(widget->font());
+    int visible = qMax(1, (widget->viewport()->height() - Margin) / metrics.lineSpacing());
+    QScrollBar* vertical = widget->verticalScrollBar();
+    vertical->setSingleStep(1);
+    vertical->setPageStep(visible);
+    vertical->setRange(0, static_cast<int>(qMax<qint64>(0, lineCount() - visible)));
+    if (follow) {
+        vertical->setValue(vertical->maximum());
+    }
+    QScrollBar* horizontal = widget->horizontalScrollBar();
+    horizontal->setSingleStep(metrics.averageCharWidth());
+    horizontal->setPageStep(widget->viewport()->width());
+    horizontal->setRange(0, qMax(0, width - widget->viewport()->width()));
+    updating = false;
+}
+
+qint64
+LogViewPrivate::size() const
+{
+    if (job) {
+        return job->logSize();
+    }
+    return text.size();
+}
+
+qint64
+LogViewPrivate::lineCount() const
+{
+    if (indexed < total) {
+        return lines.size() - 1;  // last line is still being indexed
+    }
+    return lines.size();
+}
+
+QString
+LogViewPrivate::source(qint64 position, qint64 size) const
+{
+    if (job) {
+        return job->log(position, size);
+    }
+    return text.mid(position, size);
+}
+
+QString
+LogViewPrivate::page(qint64 index)
+{
+    if (QString* cached = pages.object(index)) {
+        return *cached;
+    }
+    QString* data = new QString(source(index * PageSize, PageSize));
+    QString result = *data;
+    pages.insert(index, data);
+    return result;
+}
+
+QString
+LogViewPrivate::read(qint64 position, qint64 size)
+{
+    QString result;
+    qint64 end = qMin(position + size, total);
+    while (position < end) {
+        qint64 index = position / PageSize;
+        qint64 offset = position - index * PageSize;
+        QString data = page(index);
+        qint64 count = qMin<qint64>(end - position, data.size() - offset);
+        if (count <= 0) {
+            break;
+        }
+        result.append(QStringView(data).mid(offset, count));
+        position += count;
+    }
+    return result;
+}
+
+QString
+LogViewPrivate::line(qint64 index)
+{
+    qint64 start = lines[index];
+    qint64 end = (index + 1 < lines.size()) ? lines[index + 1] - 1 : indexed;
+    QString result = read(start, qMin<qint64>(end - start, LineSize));
+    result.remove(QLatin1Char('\r'));
+    result.replace(QLatin1Char('\t'), QLatin1String("    "));
+    return result;
+}
+
+QStringList
+LogViewPrivate::tail(int count)
+{
+    qint64 position = qMax<qint64>(0, total - PageSize);
+    QStringList result = read(position, total - position).split(QLatin1Char('\n'));
+    if (position > 0 && result.size() > 1) {
+        result.removeFirst();  // partial line at the start of the page
+    }
+    if (result.size() > count) {
+        result = result.mid(result.size() - count);
+    }
+    for (QString& line : result) {
+        line.truncate(LineSize);
+        line.remove(QLatin1Char('\r'));
+        line.replace(QLatin1Char('\t'), QLatin1String("    "));
+    }
+    return result;
+}
+
+LogViewPrivate::Cursor
+LogViewPrivate::cursorAt(const QPoint& point)
+{
+    QFontMetrics metrics(widget->font());
+    Cursor result;
+    if (lineCount() == 0) {
+        return result;
+    }
+    qint64 index = widget->verticalScrollBar()->value() + qMax(0, point.y() - Margin) / metrics.lineSpacing();
+    result.line = qBound<qint64>(0, index, lineCount() - 1);
+    QString text = line(result.line);
+    int x = point.x() - Margin + widget->horizontalScrollBar()->value();
+    int width = 0;
+    while (result.column < text.size()) {
+        int advance = metrics.horizontalAdvance(text[result.column]);
+        if (width + advance / 2 > x) {
+            break;
+        }
+        width += advance;
+        result.column++;
+    }
+    return result;
+}
+
+bool
+LogViewPrivate::selected(qint64 index, int size, int& from, int& to) const
+{
+    if (anchor == cursor) {
+        return false;
+    }
+    const Cursor start = qMin(anchor, cursor);
+    const Cursor end = qMax(anchor, cursor);
+    if (index < start.line || index > end.line) {
+        return false;
+    }
+    from = index == start.line ? qMin(start.column, size) : 0;
+    to = index == end.line ? qMin(end.column, size) : size;
+    return to > from || index < end.line;  // line break of empty lines within the selection
+}
+
+void
+LogViewPrivate::logAppended(qint64 position)
+{
+    if (position != total) {
+        reset();  // missed an update, start over
+        return;
+    }
+    pages.remove(total / PageSize);  // last page was partial
+    total = size();
+    if (!indexer.isActive()) {
+        index();
+    }
+}
+
+void
+LogViewPrivate::logReset()
+{
+    reset();
+}
+
+#include "logview.moc"
+
+LogView::LogView(QWidget* parent)
+    : QAbstractScrollArea(parent)
+    , p(new LogViewPrivate())
+{
+    p->widget = this;
+    p->init();
+}
+
+LogView::~LogView() {}
+
+QSharedPointer<Job>
+LogView::job() const
+{
+    return p->job;
+}
+
+bool
+LogView::follow() const
+{
+    return p->follow;
+}
+
+bool
+LogView::hasSelection() const
+{
+    return !(p->anchor == p->cursor);
+}
+
+QString
+LogView::selectedText() const
+{
+    QStringList text;
+    const LogViewPrivate::Cursor start = qMin(p->anchor, p->cursor);
+    const LogViewPrivate::Cursor end = qMax(p->anchor, p->cursor);
+    for (qint64 i = start.line; hasSelection() && i <= end.line && i < p->lineCount(); ++i) {
+        QString line = p->line(i);
+        int from = 0;
+        int to = 0;
+        p->selected(i, line.size(), from, to);
+        text.append(line.mid(from, to - from));
+    }
+    return text.join(QLatin1Char('\n'));
+}
+
+void
+LogView::setJob(const QSharedPointer<Job>& job)
+{
+    QObject::disconnect(p->appended);
+    QObject::disconnect(p->resetted);
+    p->job = job;
+    p->text.clear();
+    verticalScrollBar()->setValue(0);
+    if (job) {
+        p->appended = connect(job.data(), &Job::logAppended, p.data(), &LogViewPrivate::logAppended,
+                              Qt::QueuedConnection);
+        p->resetted = connect(job.data(), &Job::logReset, p.data(), &LogViewPrivate::logReset, Qt::QueuedConnection);
+        p->follow = (job->status() == Job::Running);  // running jobs open at the tail
+    }
+    else {
+        p->follow = false;
+    }
+    p->reset();
+}
+
+void
+LogView::setText(const QString& text)
+{
+    QObject::disconnect(p->appended);
+    QObject::disconnect(p->resetted);
+    p->job.clear();
+    p->text = text;
+    verticalScrollBar()->setValue(0);
+    p->follow = false;
+    p->reset();
+}
+
+void
+LogView::setFollow(bool follow)
+{
+    p->follow = follow;
+    p->updateScrollBars();
+    viewport()->update();
+}
+
+void
+LogView::selectAll()
+{
+    p->anchor = LogViewPrivate::Cursor();
+    p->cursor.line = qMax<qint64>(0, p->lineCount() - 1);
+    p->cursor.column = LogViewPrivate::LineSize;
+    viewport()->update();
+}
+
+void
+LogView::copy()
+{
+    if (hasSelection()) {
+        QGuiApplication::clipboard()->setText(selectedText());
+    }
+}
+
+void
+LogView::copyLog()
+{
+    QGuiApplication::clipboard()->setText(p->source(0, p->size()));  // unformatted, lines are not truncated
+}
+
+void
+LogView::clear()
+{
+    setText(QString());
+}
+
+void
+LogView::paintEvent(QPaintEvent* event)
+{
+    Q_UNUSED(event);
+    QPainter painter(viewport());
+    painter.setPen(palette().color(QPalette::Text));
+    QFontMetrics metrics(font());
+    int lineheight = metrics.lineSpacing();
+    int visible = viewport()->height() / lineheight + 1;
+    QStringList lines;
+    qint64 first = -1;
+    if (p->follow && p->indexed < p->total) {
+        lines = p->tail(visible);  // tail is shown before the index has caught up
+    }
+    else {
+        first = verticalScrollBar()->value();
+        qint64 last = qMin<qint64>(first + visible, p->lineCount());
+        for (qint64 i = first; i < last; ++i) {
+            lines.append(p->line(i));
+        }
+    }
+    int x = LogViewPrivate::Margin - horizontalScrollBar()->value();
+    int y = LogViewPrivate::Margin + metrics.ascent();
+    int width = p->width;
+    for (int i = 0; i < lines.size(); ++i) {
+        const QString& line = lines[i];
+        int from = 0;
+        int to = 0;
+        if (first >= 0 && p->selected(first + i, line.size(), from, to)) {
+            int left = x + metrics.horizontalAdvance(line.left(from));
+            int right = left + metrics.horizontalAdvance(line.mid(from, to - from));
+            int end = to < line.size() ? right : right + metrics.averageCharWidth();  // line break
+            painter.fillRect(QRect(left, y - metrics.ascent(), end - left, lineheight),
+                             palette().color(QPalette::Highlight));
+            painter.drawText(x, y, line.left(from));
+            painter.setPen(palette().color(QPalette::HighlightedText));
+            painter.drawText(left, y, line.mid(from, to - from));
+            painter.setPen(palette().color(QPalette::Text));
+            painter.drawText(right, y, line.mid(to));
+        }
+        else {
+            painter.drawText(x, y, line);
+        }
+        width = qMax(width, metrics.horizontalAdvance(line) + 2 * LogViewPrivate::Margin);
+        y += lineheight;
+    }
+    if (width != p->width) {
+        p->width = width;  // widest line seen so far
+        QMetaObject::invokeMethod(p.data(), [this]() { p->updateScrollBars(); }, Qt::QueuedConnection);
+    }
+}
+
+void
+LogView::resizeEvent(QResizeEvent* event)
+{
+    QAbstractScrollArea::resizeEvent(event);
+    p->updateScrollBars();
+}
+
+void
+LogView::scrollContentsBy(int dx, int dy)
+{
+    Q_UNUSED(dx);
+    Q_UNUSED(dy);
+    if (!p->updating) {
+        p->follow = verticalScrollBar()->value() >= verticalScrollBar()->maximum();
+    }
+    viewport()->update();
+}
+
+void
+LogView::mousePressEvent(QMouseEvent* event)
+{
+    if (event->button() == Qt::LeftButton) {
+        p->follow = false;  // selection stays in place while the log grows
+        p->cursor = p->cursorAt(event->position().toPoint());
+        if (!(event->modifiers() & Qt::ShiftModifier)) {
+            p->anchor = p->cursor;
+        }
+        viewport()->update();
+    }
+    QAbstractScrollArea::mousePressEvent(event);
+}
+
+void
+LogView::mouseMoveEvent(QMouseEvent* event)
+{
+    if (event->buttons() & Qt::LeftButton) {
+        QPoint point = event->position().toPoint();
+        if (point.y() < 0) {
+            verticalScrollBar()->triggerAction(QAbstractSlider::SliderSingleStepSub);
+        }
+        else if (point.y() > viewport()->height()) {
+            verticalScrollBar()->triggerAction(QAbstractSlider::SliderSingleStepAdd);
+        }
+        p->cursor = p->cursorAt(point);
+        viewport()->update();
+    }
+    QAbstractScrollArea::mouseMoveEvent(event);
+}
+
+void
+LogView::keyPressEvent(QKeyEvent* event)
+{
+    if (event->matches(QKeySequence::Copy)) {
+        copy();
+    }
+    else if (event->matches(QKeySequence::SelectAll)) {
+        selectAll();
+    }
+    else {
+        QAbstractScrollArea::keyPressEvent(event);
+    }
+}
+
+void
+LogView::contextMenuEvent(QContextMenuEvent* event)
+{
+    QMenu contextMenu(this);
+    QAction* copy = contextMenu.addAction("Copy", this, &LogView::copy);
+    copy->setEnabled(hasSelection());
+    contextMenu.addAction("Copy Log", this, &LogView::copyLog);
+    contextMenu.addSeparator();
+    contextMenu.addAction("Select All", this, &LogView::selectAll);
+    contextMenu.exec(event->globalPos());
+}
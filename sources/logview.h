@@ -0,0 +1,43 @@
+// Copyright 2022-present Contributors to the jobman project.
+// SPDX-License-Identifier: BSD-3-Clause
+// https://github.com/mikaelsundell/jobman
+
+#pragma once
+
+#include "job.h"
+
+#include <QAbstractScrollArea>
+#include <QSharedPointer>
+
+class LogViewPrivate;
+class LogView : public QAbstractScrollArea {
+    Q_OBJECT
+public:
+    LogView(QWidget* parent = nullptr);
+    virtual ~LogView();
+    QSharedPointer<Job> job() const;
+    bool follow() const;
+    bool hasSelection() const;
+    QString selectedText() const;
+
+public Q_SLOTS:
+    void setJob(const QSharedPointer<Job>& job);
+    void setText(const QString& text);
+    void setFollow(bool follow);
+    void selectAll();
+    void copy();
+    void copyLog();
+    void clear();
+
+protected:
+    void paintEvent(QPaintEvent* event) override;
+    void resizeEvent(QResizeEvent* event) override;
+    void scrollContentsBy(int dx, int dy) override;
+    void mousePressEvent(QMouseEvent* event) override;
+    void mouseMoveEvent(QMouseEvent* event) override;
+    void keyPressEvent(QKeyEvent* event) override;
+    void contextMenuEvent(QContextMenuEvent* event) override;
+
+private:
+    QScopedPointer<LogViewPrivate> p;
+};
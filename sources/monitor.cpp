@@ -11,6 +11,7 @@
 #include <QDateTime>
 #include <QDesktopServices>
 #include <QDir>
+#include <QElapsedTimer>
 #include <QMenu>
 #include <QPainter>
 #include <QPointer>
@@ -40,19 +41,20 @@ public:
     void updateProgress(QTreeWidgetItem* item);
     void updatePriority(Priority priority);
     void updateMetrics();
+    void updateDashboard();
     bool eventFilter(QObject* object, QEvent* event);
 
 public Q_SLOTS:
     void batchSubmitted(const QList<QSharedPointer<Job>>& jobs);
     void jobsSubmitted(const QList<QSharedPointer<Job>>& jobs);
     void jobsRemoved(const QList<QUuid>& uuids);
-    void logChanged(const QString& log);
     void priorityChanged(int priority);
     void statusChanged(Job::Status status);
     void selectionChanged();
     void toggleButtons();
     void start();
     void stop();
+    void cancel();
     void restart();
     void priority();
     void remove();
@@ -95,7 +97,7 @@ public:
             else if (status == "Running") {
                 color = QColor::fromHsl(120, 150, 50).rgb();
             }
-            else if (status == "Completed") {
+            else if (status.startsWith("Completed")) {
                 color = QColor::fromHsl(120, 90, 40).rgb();
             }
             else {
@@ -191,18 +193,26 @@ public:
         }
     }
     QSize size;
-    QMetaObject::Connection logchanged;
     QTreeWidgetItem* findTopLevelItem(QTreeWidgetItem* item);
     QTreeWidgetItem* findItemByUuid(const QUuid& uuid);
     QSharedPointer<Job> itemJob(QTreeWidgetItem* item);
+    QString duration(qint64 milliseconds);
     QSharedPointer<Job> jobitem;
     QHash<QUuid, QTreeWidgetItem*> jobitems;
+    std::shared_ptr<const QueueSnapshot> sampled;
+    QElapsedTimer sampledtime;
+    qreal throughput;
+    QTimer sampler;
     QPointer<Queue> queue;
     QPointer<Monitor> dialog;
     QScopedPointer<Ui_Monitor> ui;
 };
 
-MonitorPrivate::MonitorPrivate() { qRegisterMetaType<QSharedPointer<Job>>("QSharedPointer<Job>"); }
+MonitorPrivate::MonitorPrivate()
+    : throughput(0.0)
+{
+    qRegisterMetaType<QSharedPointer<Job>>("QSharedPointer<Job>");
+}
 
 void
 MonitorPrivate::init()
@@ -229,10 +239,16 @@ MonitorPrivate::init()
     ui->items->setItemDelegateForColumn(3, new PriorityDelegate(ui->items));
     ui->items->setItemDelegateForColumn(4, new StatusDelegate(ui->items));
     ui->items->setContextMenuPolicy(Qt::CustomContextMenu);
-    QPalette palette = ui->job->palette();  // workaround for unfocused textbrowser
-    QColor textcolor = QColor::fromHslF(0.0, 0.0, 0.8);
-    palette.setColor(QPalette::Inactive, QPalette::HighlightedText, textcolor);
-    ui->job->setPalette(palette);
+    // dashboard
+    ui->throughput->setTitle("Jobs/sec");
+    ui->wait->setTitle("Wait");
+    ui->run->setTitle("Run");
+    ui->active->setTitle("Slots");
+    ui->cpu->setTitle("CPU");
+    ui->eta->setTitle("ETA");
+    sampled = queue->snapshot();
+    sampledtime.start();
+    sampler.setInterval(1000);
     // event filter
     dialog->installEventFilter(this);
     // layout
@@ -251,6 +267,7 @@ MonitorPrivate::init()
     connect(ui->items, &QTreeWidget::customContextMenuRequested, this, &MonitorPrivate::showMenu);
     connect(ui->filter, &QLineEdit::textChanged, ui->items, &JobTree::setFilter);
     connect(ui->clear, &QPushButton::pressed, this, &MonitorPrivate::clear);
+    connect(&sampler, &QTimer::timeout, this, &MonitorPrivate::updateDashboard);
     connect(queue.data(), &Queue::batchSubmitted, this, &MonitorPrivate::batchSubmitted);
     connect(queue.data(), &Queue::jobsSubmitted, this, &MonitorPrivate::jobsSubmitted);
     connect(queue.data(), &Queue::jobsRemoved, this, &MonitorPrivate::jobsRemoved);
@@ -273,7 +290,7 @@ MonitorPrivate::updateJob(QTreeWidgetItem* item)
         item->setText(Status, "Running");
     } break;
     case Job::Completed: {
-        item->setText(Status, "Completed");
+        item->setText(Status, job->skipped() ? "Completed (Skipped)" : "Completed");
     } break;
     case Job::DependencyFailed: {
         item->setText(Status, "Dependency failed");
@@ -328,12 +345,17 @@ MonitorPrivate::updateProgress(QTreeWidgetItem* item)
 void
 MonitorPrivate::updatePriority(enum Priority priority)
 {
-    selectedItems([this, &priority](const QTreeWidgetItem* item, const QSharedPointer<Job>& job) {
+    QList<QUuid> uuids;
+    QSet<QUuid> prioritizeduuids;
+    selectedItems([this, &uuids, &prioritizeduuids](const QTreeWidgetItem* item, const QSharedPointer<Job>& job) {
         QTreeWidgetItem* parentItem = findItemByUuid(job->uuid());
         std::function<void(QTreeWidgetItem*)> priorityItems = [&](QTreeWidgetItem* parentItem) {
             QVariant data = parentItem->data(0, Qt::UserRole);
             QSharedPointer<Job> job = data.value<QSharedPointer<Job>>();
-            job->setPriority(priority);
+            if (!prioritizeduuids.contains(job->uuid())) {
+                prioritizeduuids.insert(job->uuid());
+                uuids.append(job->uuid());
+            }
             for (int i = 0; i < parentItem->childCount(); ++i) {
                 priorityItems(parentItem->child(i));
             }
@@ -341,31 +363,20 @@ MonitorPrivate::updatePriority(enum Priority priority)
         priorityItems(parentItem);
         return false;
     });
+    if (!uuids.isEmpty()) {
+        queue->setPriorityAsync(uuids, priority);  // single queue transaction for the whole selection
+    }
 }
 
 void
 MonitorPrivate::updateMetrics()
 {
-    int waitingCount = 0;
-    int completedCount = 0;
-    int dependencyFailedCount = 0;
-    int stoppedCount = 0;
-    int runningCount = 0;
-    int failedCount = 0;
-    for (auto it = jobitems.constBegin(); it != jobitems.constEnd(); ++it) {
-        QTreeWidgetItem* item = it.value();
-        QVariant data = item->data(0, Qt::UserRole);
-        QSharedPointer<Job> job = data.value<QSharedPointer<Job>>();
-        switch (job->status()) {
-        case Job::Waiting: waitingCount++; break;
-        case Job::Running: runningCount++; break;
-        case Job::Completed: completedCount++; break;
-        case Job::DependencyFailed: dependencyFailedCount++; break;
-        case Job::Failed: failedCount++; break;
-        case Job::Stopped: stoppedCount++; break;
-        default: break;
-        }
-    }
+    const std::shared_ptr<const QueueSnapshot> snapshot = queue->snapshot();  // no job or queue locks
+    int waitingCount = snapshot->jobs.count(Job::Waiting);
+    int completedCount = snapshot->jobs.count(Job::Completed);
+    int stoppedCount = snapshot->jobs.count(Job::Stopped);
+    int runningCount = snapshot->jobs.count(Job::Running);
+    int failedCount = snapshot->jobs.count(Job::Failed);
     QStringList parts;
     if (waitingCount > 0)
         parts << QString("waiting: %1").arg(waitingCount);
@@ -387,13 +398,69 @@ MonitorPrivate::updateMetrics()
     if (percentage > 0 && percentage < 100) {
         metricsText.append(QString(" - %1%").arg(percentage));
     }
+    if (snapshot->skipped > 0) {
+        metricsText.append(QString(" - Skipped: %1 up to date").arg(snapshot->skipped));
+    }
+    if (snapshot->cachehits + snapshot->cachemisses > 0) {
+        metricsText.append(
+            QString(" - Cache: %1 hits, %2 misses").arg(snapshot->cachehits).arg(snapshot->cachemisses));
+    }
     ui->metrics->setText(metricsText);
 }
 
+void
+MonitorPrivate::updateDashboard()
+{
+    const std::shared_ptr<const QueueSnapshot> snapshot = queue->snapshot();  // counters only, jobs are not scanned
+    const qreal seconds = qMax<qint64>(1, sampledtime.restart()) / 1000.0;
+    const quint64 started = snapshot->started - sampled->started;
+    const quint64 finished = snapshot->finished - sampled->finished;
+    throughput = 0.3 * (finished / seconds) + 0.7 * throughput;  // smoothed for a stable eta
+    ui->throughput->addValue(throughput);
+    ui->throughput->setText(QString::number(throughput, 'f', 1));
+    if (started > 0) {
+        const qint64 wait = (snapshot->waittime - sampled->waittime) / static_cast<qint64>(started);
+        ui->wait->addValue(wait);
+        ui->wait->setText(duration(wait));
+    }
+    else {
+        ui->wait->addValue(0);
+    }
+    if (finished > 0) {
+        const qint64 run = (snapshot->runtime - sampled->runtime) / static_cast<qint64>(finished);
+        ui->run->addValue(run);
+        ui->run->setText(duration(run));
+    }
+    else {
+        ui->run->addValue(0);
+    }
+    ui->active->addValue(snapshot->activeslots);
+    ui->active->setText(QString("%1 / %2").arg(snapshot->activeslots).arg(snapshot->concurrency));
+    ui->cpu->addValue(snapshot->cpu);
+    ui->cpu->setText(QString("%1%").arg(snapshot->cpu, 0, 'f', 0));
+    const int remaining = snapshot->jobs.count(Job::Waiting) + snapshot->jobs.count(Job::Running);
+    if (remaining > 0 && throughput > 0.01) {
+        const qint64 eta = static_cast<qint64>(remaining / throughput * 1000.0);
+        ui->eta->addValue(eta / 1000.0);
+        ui->eta->setText(duration(eta));
+    }
+    else {
+        ui->eta->addValue(0);
+        ui->eta->setText(remaining > 0 ? "-" : "");
+    }
+    sampled = snapshot;
+}
+
 bool
 MonitorPrivate::eventFilter(QObject* object, QEvent* event)
 {
+    if (event->type() == QEvent::Hide) {
+        sampler.stop();
+    }
     if (event->type() == QEvent::Show) {
+        sampled = queue->snapshot();
+        sampledtime.restart();
+        sampler.start();  // sampled while visible
         QList<int> sizes;
         int height = ui->splitter->height();
         int jobsHeight = height * 0.75;
@@ -414,10 +481,10 @@ MonitorPrivate::batchSubmitted(const QList<QSharedPointer<Job>>& jobs)
             continue;
 
         QTreeWidgetItem* parent = nullptr;
-        const QUuid dependsonUuid = job->dependson();
+        const QList<QUuid> dependson = job->dependson();
 
-        if (!dependsonUuid.isNull())
-            parent = findItemByUuid(dependsonUuid);
+        if (!dependson.isEmpty())
+            parent = findItemByUuid(dependson.first());  // tree shows the first of several parents
 
         QTreeWidgetItem* item = new QTreeWidgetItem();
         item->setData(0, Qt::UserRole, QVariant::fromValue(job));
@@ -494,9 +561,6 @@ MonitorPrivate::jobsRemoved(const QList<QUuid>& uuids)
     }
 
     if (jobitem && uuids.contains(jobitem->uuid())) {
-        if (logchanged)
-            QObject::disconnect(logchanged);
-
         jobitem.clear();
         ui->job->clear();
     }
@@ -508,18 +572,6 @@ MonitorPrivate::jobsRemoved(const QList<QUuid>& uuids)
     selectionChanged();
 }
 
-void
-MonitorPrivate::logChanged(const QString& log)
-{
-    QUuid uuid = qobject_cast<Job*>(sender())->uuid();
-    if (jobitems.contains(uuid)) {
-        QTreeWidgetItem* item = jobitems[uuid];
-        if (item->isSelected()) {
-            ui->job->setText(log);
-        }
-    }
-}
-
 void
 MonitorPrivate::priorityChanged(int priority)
 {
@@ -533,7 +585,8 @@ MonitorPrivate::priorityChanged(int priority)
 void
 MonitorPrivate::statusChanged(Job::Status status)
 {
-    QUuid uuid = qobject_cast<Job*>(sender())->uuid();
+    Job* job = qobject_cast<Job*>(sender());
+    QUuid uuid = job->uuid();
     if (jobitems.contains(uuid)) {
         QTreeWidgetItem* item = jobitems[uuid];
         switch (status) {
@@ -544,7 +597,7 @@ MonitorPrivate::statusChanged(Job::Status status)
             item->setText(Status, "Running");
         } break;
         case Job::Completed: {
-            item->setText(Status, "Completed");
+            item->setText(Status, job->skipped() ? "Completed (Skipped)" : "Completed");
         } break;
         case Job::DependencyFailed: {
             item->setText(Status, "Dependency failed");
@@ -565,9 +618,6 @@ MonitorPrivate::statusChanged(Job::Status status)
 void
 MonitorPrivate::selectionChanged()
 {
-    if (logchanged) {
-        QObject::disconnect(logchanged);  // prevent flooding the event loop
-    }
     jobitem.clear();
     qint64 selectionCount = ui->items->selectedItems().count();
     if (selectionCount > 0) {
@@ -576,21 +626,14 @@ MonitorPrivate::selectionChanged()
             QVariant data = item->data(0, Qt::UserRole);
             QSharedPointer<Job> job = data.value<QSharedPointer<Job>>();
             jobitem = job;
-            ui->job->setText(job->log());
-            logchanged = connect(
-                job.data(), &Job::logChanged, this,
-                [this]() {
-                    if (jobitem)
-                        ui->job->setText(jobitem->log());
-                },
-                Qt::QueuedConnection);
+            ui->job->setJob(job);  // log is paged in and follows appended output
         }
         else {
             ui->job->setText("[Multiple selection]");
         }
     }
     else {
-        ui->job->setText(QString());
+        ui->job->clear();
     }
 
     toggleButtons();
@@ -662,21 +705,51 @@ MonitorPrivate::toggleButtons()
 void
 MonitorPrivate::start()
 {
-    selectedItems([this](const QTreeWidgetItem* item, const QSharedPointer<Job>& job) {
-        queue->start(job->uuid());
+    QList<QUuid> uuids;
+    QSet<QUuid> selecteduuids;
+    selectedItems([&uuids, &selecteduuids](const QTreeWidgetItem* item, const QSharedPointer<Job>& job) {
+        if (job->status() == Job::Stopped && !selecteduuids.contains(job->uuid())) {
+            selecteduuids.insert(job->uuid());
+            uuids.append(job->uuid());
+        }
         return false;
     });
-    toggleButtons();
+    if (!uuids.isEmpty()) {
+        queue->startAsync(uuids).then(this, [this]() { toggleButtons(); });
+    }
 }
 
 void
 MonitorPrivate::stop()
 {
-    selectedItems([this](const QTreeWidgetItem* item, const QSharedPointer<Job>& job) {
-        queue->stop(job->uuid());
+    QList<QUuid> uuids;
+    QSet<QUuid> selecteduuids;
+    selectedItems([&uuids, &selecteduuids](const QTreeWidgetItem* item, const QSharedPointer<Job>& job) {
+        if (job->status() == Job::Running && !selecteduuids.contains(job->uuid())) {
+            selecteduuids.insert(job->uuid());
+            uuids.append(job->uuid());
+        }
         return false;
     });
-    toggleButtons();
+    if (!uuids.isEmpty()) {
+        queue->stopAsync(uuids).then(this, [this]() { toggleButtons(); });
+    }
+}
+
+void
+MonitorPrivate::cancel()
+{
+    QList<QUuid> batches;
+    selectedItems([&batches](const QTreeWidgetItem* item, const QSharedPointer<Job>& job) {
+        QUuid batch = job->batch();
+        if (!batch.isNull() && !batches.contains(batch)) {
+            batches.append(batch);
+        }
+        return false;
+    });
+    for (const QUuid& batch : batches) {
+        queue->cancelAsync(batch).then(this, [this]() { toggleButtons(); });
+    }
 }
 
 void
@@ -700,8 +773,7 @@ MonitorPrivate::restart()
             uuids.push_back(job->uuid());
         }
     }
-    queue->restart(uuids);
-    toggleButtons();
+    queue->restartAsync(uuids).then(this, [this]() { toggleButtons(); });
 }
 
 void
@@ -766,7 +838,7 @@ MonitorPrivate::remove()
     }
 
     if (!uuids.isEmpty())
-        queue->remove(uuids);
+        queue->removeAsync(uuids);
 }
 
 void
@@ -1020,6 +1092,21 @@ MonitorPrivate::showMenu(const QPoint& pos)
         restart->setEnabled(ui->restart->isEnabled());
         contextMenu.addAction(restart);
 
+        QAction* cancel = new QAction("Cancel batch", this);
+        connect(cancel, &QAction::triggered, this, &MonitorPrivate::cancel);
+        {
+            bool enabled = false;
+            selectedItems([&enabled](const QTreeWidgetItem* item, const QSharedPointer<Job>& job) {
+                if (!job->batch().isNull() && (job->status() == Job::Waiting || job->status() == Job::Running)) {
+                    enabled = true;
+                    return true;
+                }
+                return false;
+            });
+            cancel->setEnabled(enabled);
+        }
+        contextMenu.addAction(cancel);
+
         QAction* priority = new QAction("Priority", this);
         {
             QMenu* priorityMenu = new QMenu(ui->items);
@@ -1105,6 +1192,22 @@ MonitorPrivate::findItemByUuid(const QUuid& uuid)
     return jobitems.value(uuid, nullptr);
 }
 
+QString
+MonitorPrivate::duration(qint64 milliseconds)
+{
+    if (milliseconds < 1000) {
+        return QString("%1 ms").arg(milliseconds);
+    }
+    qint64 seconds = milliseconds / 1000;
+    if (seconds < 60) {
+        return QString("%1 s").arg(seconds);
+    }
+    if (seconds < 3600) {
+        return QString("%1m %2s").arg(seconds / 60).arg(seconds % 60);
+    }
+    return QString("%1h %2m").arg(seconds / 3600).arg((seconds % 3600) / 60);
+}
+
 QSharedPointer<Job>
 MonitorPrivate::itemJob(QTreeWidgetItem* item)
 {
@@ -31,4 +31,8 @@ void
 openPaths(const QList<QString>& paths);
 double
 getCpuUsage();
+qint64
+getPhysicalMemory();
+bool
+cloneFile(const QString& source, const QString& target);
 }  // namespace platform
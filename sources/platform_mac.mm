@@ -8,6 +8,8 @@
 #import <Cocoa/Cocoa.h>
 
 #include <os/log.h>
+#include <sys/clonefile.h>
+#include <sys/sysctl.h>
 #include <QApplication>
 #include <QFileInfo>
 #include <QScreen>
@@ -240,6 +242,22 @@ namespace platform {
         return totalcpu / numcpus;
     }
 
+    qint64 getPhysicalMemory()
+    {
+        int64_t memsize = 0;
+        size_t size = sizeof(memsize);
+        if (sysctlbyname("hw.memsize", &memsize, &size, NULL, 0) != 0) {
+            return 0;
+        }
+        return memsize;
+    }
+
+    bool cloneFile(const QString& source, const QString& target)
+    {
+        // copy-on-write on apfs, fails on other file systems
+        return clonefile(source.toUtf8().constData(), target.toUtf8().constData(), 0) == 0;
+    }
+
     void console(const QString& log)
     {
         NSLog(@"%@", log.toNSString());
@@ -195,4 +195,23 @@ getCpuUsage()
     double cpuUsage = (totalDiff - idleDiff) * 100.0 / totalDiff;
     return cpuUsage;
 }
+
+qint64
+getPhysicalMemory()
+{
+    MEMORYSTATUSEX status;
+    status.dwLength = sizeof(status);
+    if (GlobalMemoryStatusEx(&status) == 0) {
+        return 0;
+    }
+    return static_cast<qint64>(status.ullTotalPhys);
+}
+
+bool
+cloneFile(const QString& source, const QString& target)
+{
+    Q_UNUSED(source);
+    Q_UNUSED(target);
+    return false;  // block cloning needs refs volumes, callers fall back to copy
+}
 }  // namespace platform
@@ -9,6 +9,9 @@
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QPointer>
+#include <QRegularExpression>
+
+#include <cmath>
 
 Option::Option() {}
 
@@ -23,6 +26,7 @@ public:
     PresetPrivate();
     void init();
     bool read();
+    qint64 readMemory(const QVariant& value);
 
 public:
     QString id;
@@ -35,12 +39,19 @@ public:
     QList<QSharedPointer<Option>> options;
     QList<QSharedPointer<Task>> tasks;
     QUuid uuid;
+    bool incremental;
+    bool cache;
+    int weight;
+    QMap<QString, int> groups;  // limit per concurrency group, declared once for all tasks
     bool valid;
     QPointer<Preset> preset;
 };
 
 PresetPrivate::PresetPrivate()
-    : valid(false)
+    : incremental(false)
+    , cache(false)
+    , weight(1)
+    , valid(false)
     , uuid(QUuid::createUuid())
 {}
 
@@ -116,6 +127,39 @@ PresetPrivate::read()
     if (json.contains("filter") && json["filter"].isString()) {
         filter = json["filter"].toString();
     }
+    if (json.contains("incremental") && json["incremental"].isBool()) {
+        incremental = json["incremental"].toBool();
+    }
+    if (json.contains("cache") && json["cache"].isBool()) {
+        cache = json["cache"].toBool();
+    }
+    if (json.contains("weight")) {
+        if (!json["weight"].isDouble() || json["weight"].toInt() < 1) {
+            error = QString("Json for preset: \"%1\" contains weight that is not a positive number").arg(filename);
+            valid = false;
+            return valid;
+        }
+        weight = json["weight"].toInt();
+    }
+    if (json.contains("groups")) {
+        if (!json["groups"].isObject()) {
+            error = QString("Json for preset: \"%1\" contains groups that is not an object").arg(filename);
+            valid = false;
+            return valid;
+        }
+        const QJsonObject jsongroups = json["groups"].toObject();
+        for (auto it = jsongroups.constBegin(); it != jsongroups.constEnd(); ++it) {
+            if (!it.value().isDouble() || it.value().toInt() < 1) {
+                error = QString("Json for preset: \"%1\" contains group: \"%2\" with a limit that is not a positive "
+                                "number")
+                            .arg(filename)
+                            .arg(it.key());
+                valid = false;
+                return valid;
+            }
+            groups.insert(it.key(), it.value().toInt());
+        }
+    }
     if (!type.length()) {
         type = "file";
     }
@@ -323,8 +367,19 @@ PresetPrivate::read()
                 task->arguments = jsontask["arguments"].toString();
             if (jsontask.contains("startin") && jsontask["startin"].isString())
                 task->startin = jsontask["startin"].toString();
-            if (jsontask.contains("dependson") && jsontask["dependson"].isString())
-                task->dependson = jsontask["dependson"].toString();
+            if (jsontask.contains("dependson")) {
+                if (jsontask["dependson"].isString()) {
+                    task->dependson.append(jsontask["dependson"].toString());
+                }
+                else if (jsontask["dependson"].isArray()) {
+                    QJsonArray dependsonarray = jsontask["dependson"].toArray();
+                    for (int i = 0; i < dependsonarray.size(); ++i) {
+                        task->dependson.append(dependsonarray[i].toString());
+                    }
+                }
+                task->dependson.removeAll(QString());
+                task->dependson.removeDuplicates();
+            }
             if (jsontask.contains("documentation") && jsontask["documentation"].isArray()) {
                 QJsonArray docarray = jsontask["documentation"].toArray();
                 for (int i = 0; i < docarray.size(); ++i) {
@@ -333,6 +388,195 @@ PresetPrivate::read()
             }
             if (jsontask.contains("exclusive"))
                 task->exclusive = jsontask["exclusive"].toVariant();
+            if (jsontask.contains("slots")) {
+                const double cpuslots = jsontask["slots"].toDouble();
+                if (!jsontask["slots"].isDouble() || cpuslots < 1 || cpuslots != std::floor(cpuslots)) {
+                    error = QString("Json for task: \"%1\" contains slots that is not a positive integer")
+                                .arg(task->name);
+                    valid = false;
+                    return valid;
+                }
+                task->cpuslots = jsontask["slots"].toInt();
+            }
+            if (jsontask.contains("group")) {
+                if (jsontask["group"].isString()) {
+                    task->groups.append(jsontask["group"].toString());
+                }
+                else if (jsontask["group"].isArray()) {
+                    QJsonArray grouparray = jsontask["group"].toArray();
+                    for (int i = 0; i < grouparray.size(); ++i) {
+                        task->groups.append(grouparray[i].toString());
+                    }
+                }
+                task->groups.removeAll(QString());
+                for (const QString& group : task->groups) {
+                    if (!groups.contains(group)) {
+                        error = QString("Json for task: \"%1\" contains group: \"%2\" that is not declared in the "
+                                        "preset groups object")
+                                    .arg(task->name)
+                                    .arg(group);
+                        valid = false;
+                        return valid;
+                    }
+                }
+            }
+            if (jsontask.contains("limit")) {
+                error = QString("Json for task: \"%1\" contains limit, group limits are declared once in the preset "
+                                "groups object")
+                            .arg(task->name);
+                valid = false;
+                return valid;
+            }
+            if (jsontask.contains("memory")) {
+                qint64 memory = readMemory(jsontask["memory"].toVariant());
+                if (memory < 0) {
+                    error = QString("Json for task: \"%1\" contains memory that can not be parsed, use bytes or "
+                                    "a K, M or G suffix")
+                                .arg(task->name);
+                    valid = false;
+                    return valid;
+                }
+                task->memory = memory;
+            }
+            if (jsontask.contains("retry")) {
+                if (!jsontask["retry"].isObject()) {
+                    error = QString("Json for task: \"%1\" contains retry that is not an object").arg(task->name);
+                    valid = false;
+                    return valid;
+                }
+                QJsonObject jsonretry = jsontask["retry"].toObject();
+                if (!jsonretry["attempts"].isDouble() || jsonretry["attempts"].toInt() < 1) {
+                    error = QString("Json for task: \"%1\" contains retry attempts that is not a positive number")
+                                .arg(task->name);
+                    valid = false;
+                    return valid;
+                }
+                task->attempts = jsonretry["attempts"].toInt();
+                if (jsonretry.contains("delay"))
+                    task->delay = qMax(0.0, jsonretry["delay"].toDouble());
+                if (jsonretry.contains("maxdelay"))
+                    task->maxdelay = qMax(0.0, jsonretry["maxdelay"].toDouble());
+                QJsonArray exitcodes = jsonretry["exitcodes"].toArray();
+                for (int i = 0; i < exitcodes.size(); ++i) {
+                    task->exitcodes.append(exitcodes[i].toInt());
+                }
+                QJsonArray signalcodes = jsonretry["signals"].toArray();
+                for (int i = 0; i < signalcodes.size(); ++i) {
+                    task->signalcodes.append(signalcodes[i].toInt());
+                }
+                QJsonArray patterns = jsonretry["patterns"].toArray();
+                for (int i = 0; i < patterns.size(); ++i) {
+                    QString pattern = patterns[i].toString();
+                    if (!QRegularExpression(pattern).isValid()) {
+                        error = QString("Json for task: \"%1\" contains retry pattern that can not be parsed: %2")
+                                    .arg(task->name)
+                                    .arg(pattern);
+                        valid = false;
+                        return valid;
+                    }
+                    task->patterns.append(pattern);
+                }
+            }
+            if (jsontask.contains("timeout")) {
+                if (!jsontask["timeout"].isDouble() || jsontask["timeout"].toInt() < 1) {
+                    error = QString("Json for task: \"%1\" contains timeout that is not a positive number")
+                                .arg(task->name);
+                    valid = false;
+                    return valid;
+                }
+                task->timeout = jsontask["timeout"].toInt();
+            }
+            if (jsontask.contains("idle_timeout")) {
+                if (!jsontask["idle_timeout"].isDouble() || jsontask["idle_timeout"].toInt() < 1) {
+                    error = QString("Json for task: \"%1\" contains idle_timeout that is not a positive number")
+                                .arg(task->name);
+                    valid = false;
+                    return valid;
+                }
+                task->idletimeout = jsontask["idle_timeout"].toInt();
+            }
+            if (jsontask.contains("chunk")) {
+                QJsonObject jsonchunk = jsontask["chunk"].toObject();
+                QString unit = jsonchunk["unit"].toString();
+                if (unit != "frames" && unit != "seconds" && unit != "bytes") {
+                    error = QString("Json for task: \"%1\" contains chunk unit that is not frames, seconds or bytes")
+                                .arg(task->name);
+                    valid = false;
+                    return valid;
+                }
+                if (jsonchunk.contains("count") && (!jsonchunk["count"].isDouble() || jsonchunk["count"].toInt() < 1)) {
+                    error = QString("Json for task: \"%1\" contains chunk count that is not a positive number")
+                                .arg(task->name);
+                    valid = false;
+                    return valid;
+                }
+                if (jsonchunk.contains("probe") && jsonchunk["probe"].toString().trimmed().isEmpty()) {
+                    error = QString("Json for task: \"%1\" contains chunk probe that is not a command")
+                                .arg(task->name);
+                    valid = false;
+                    return valid;
+                }
+                if ((unit != "bytes" && !jsonchunk["end"].isDouble() && !jsonchunk.contains("probe"))
+                    || jsonchunk["start"].toDouble() > jsonchunk["end"].toDouble(jsonchunk["start"].toDouble())) {
+                    error = QString("Json for task: \"%1\" contains chunk end that is missing or before start")
+                                .arg(task->name);
+                    valid = false;
+                    return valid;
+                }
+                task->chunkunit = unit;
+                task->chunkcount = jsonchunk["count"].toInt();  // zero derives the count from threads
+                task->chunkstart = jsonchunk["start"].toDouble();
+                if (jsonchunk.contains("end"))
+                    task->chunkend = jsonchunk["end"].toDouble();
+                task->chunkprobe = jsonchunk["probe"].toString();
+            }
+            if (jsontask.contains("batch")) {
+                QJsonObject jsonbatch = jsontask["batch"].toObject();
+                if (!jsonbatch["max_files"].isDouble() || jsonbatch["max_files"].toInt() < 2) {
+                    error = QString("Json for task: \"%1\" contains batch max_files that is not a number above one")
+                                .arg(task->name);
+                    valid = false;
+                    return valid;
+                }
+                if (jsonbatch.contains("max_argv_bytes")
+                    && (!jsonbatch["max_argv_bytes"].isDouble() || jsonbatch["max_argv_bytes"].toInt() < 1)) {
+                    error = QString("Json for task: \"%1\" contains batch max_argv_bytes that is not a positive number")
+                                .arg(task->name);
+                    valid = false;
+                    return valid;
+                }
+                if (jsonbatch.contains("response") && !jsonbatch["response"].toString().contains("%file%")) {
+                    error = QString("Json for task: \"%1\" contains batch response without %file%").arg(task->name);
+                    valid = false;
+                    return valid;
+                }
+                task->batchfiles = jsonbatch["max_files"].toInt();
+                if (jsonbatch.contains("max_argv_bytes"))
+                    task->batchbytes = jsonbatch["max_argv_bytes"].toInt();
+                task->batchresponse = jsonbatch["response"].toString();
+            }
+            if (jsontask.contains("intermediate"))
+                task->intermediate = jsontask["intermediate"].toVariant();
+            if (jsontask.contains("jobserver"))
+                task->jobserver = jsontask["jobserver"].toVariant();
+            if (jsontask.contains("pipe"))
+                task->pipe = jsontask["pipe"].toVariant();
+            if (jsontask.contains("worker")) {
+                if (!jsontask["worker"].isObject()) {
+                    error = QString("Json for task: \"%1\" contains worker that is not an object").arg(task->name);
+                    valid = false;
+                    return valid;
+                }
+                QJsonObject jsonworker = jsontask["worker"].toObject();
+                if (jsonworker.contains("jobs") && (!jsonworker["jobs"].isDouble() || jsonworker["jobs"].toInt() < 1)) {
+                    error = QString("Json for task: \"%1\" contains worker jobs that is not a positive number")
+                                .arg(task->name);
+                    valid = false;
+                    return valid;
+                }
+                task->workerjobs = jsonworker.contains("jobs") ? jsonworker["jobs"].toInt() : 100;
+                task->workerarguments = jsonworker["arguments"].toString();
+            }
             if (!task->id.isEmpty() && !task->name.isEmpty() && !task->command.isEmpty() && !task->extension.isEmpty()
                 && !task->arguments.isEmpty()) {
                 // validation
@@ -343,10 +587,10 @@ PresetPrivate::read()
                         return valid;
                     }
                 }
-                if (task->dependson.length() > 0) {
+                for (const QString& dependson : task->dependson) {
                     bool found = false;
                     for (int j = 0; j < tasks.size(); ++j) {
-                        if (tasks[j]->id == task->dependson) {
+                        if (tasks[j]->id == dependson) {
                             found = true;
                             break;
                         }
@@ -358,6 +602,29 @@ PresetPrivate::read()
                         return valid;
                     }
                 }
+                if (task->pipe.toBool()) {
+                    // the parent runs both commands, each must be a single plain job for each file
+                    auto plain = [](const QSharedPointer<Task>& other) {
+                        return other->chunkunit.isEmpty() && other->batchfiles.toInt() == 0
+                               && other->workerjobs.toInt() == 0;
+                    };
+                    bool pipeable = task->dependson.size() == 1 && plain(task);
+                    for (QSharedPointer<Task> other : tasks) {
+                        if (other->id == task->dependson.value(0) && (!plain(other) || other->pipe.toBool())) {
+                            pipeable = false;
+                        }
+                        if (other->pipe.toBool() && other->dependson == task->dependson) {
+                            pipeable = false;
+                        }
+                    }
+                    if (!pipeable) {
+                        error = QString("Json for task: \"%1\" contains pipe that needs a single dependson task and "
+                                        "no chunk, batch, worker or other task piped from it")
+                                    .arg(task->name);
+                        valid = false;
+                        return valid;
+                    }
+                }
                 tasks.append(task);
             }
             else {
@@ -386,6 +653,49 @@ PresetPrivate::read()
             if (task->exclusive.isNull()) {
                 task->exclusive = false;
             }
+            if (task->cpuslots.isNull()) {
+                task->cpuslots = 1;
+            }
+            if (task->memory.isNull()) {
+                task->memory = 0;
+            }
+            if (task->attempts.isNull()) {
+                task->attempts = 1;
+            }
+            if (task->delay.isNull()) {
+                task->delay = 1.0;
+            }
+            if (task->maxdelay.isNull()) {
+                task->maxdelay = 60.0;
+            }
+            if (task->timeout.isNull()) {
+                task->timeout = 0;
+            }
+            if (task->idletimeout.isNull()) {
+                task->idletimeout = 0;
+            }
+            if (task->batchfiles.isNull()) {
+                task->batchfiles = 0;
+            }
+            if (task->intermediate.isNull()) {
+                task->intermediate = false;
+            }
+            if (task->jobserver.isNull()) {
+                task->jobserver = false;
+            }
+            if (task->pipe.isNull()) {
+                task->pipe = false;
+            }
+            if (task->workerjobs.isNull()) {
+                task->workerjobs = 0;
+            }
+            if (task->batchbytes.isNull()) {
+#ifdef Q_OS_WIN
+                task->batchbytes = 32000;  // command line limit
+#else
+                task->batchbytes = 256 * 1024;  // well below ARG_MAX with the environment
+#endif
+            }
         }
     }
     else {
@@ -397,6 +707,37 @@ PresetPrivate::read()
     return valid;
 }
 
+qint64
+PresetPrivate::readMemory(const QVariant& value)
+{
+    if (value.typeId() == QMetaType::Double || value.typeId() == QMetaType::LongLong) {
+        return qMax<qint64>(-1, value.toLongLong());  // plain bytes
+    }
+    QString memory = value.toString().trimmed().toUpper();
+    qint64 scale = 1;
+    if (memory.endsWith("B")) {
+        memory.chop(1);
+    }
+    if (memory.endsWith("K")) {
+        scale = 1024LL;
+    }
+    else if (memory.endsWith("M")) {
+        scale = 1024LL * 1024;
+    }
+    else if (memory.endsWith("G")) {
+        scale = 1024LL * 1024 * 1024;
+    }
+    if (scale > 1) {
+        memory.chop(1);
+    }
+    bool ok = false;
+    double size = memory.toDouble(&ok);
+    if (!ok || size < 0) {
+        return -1;
+    }
+    return static_cast<qint64>(size * scale);
+}
+
 
 Preset::Preset()
     : p(new PresetPrivate())
@@ -456,6 +797,30 @@ Preset::filter() const
     return p->filter;
 }
 
+bool
+Preset::incremental() const
+{
+    return p->incremental;
+}
+
+bool
+Preset::cache() const
+{
+    return p->cache;
+}
+
+int
+Preset::weight() const
+{
+    return p->weight;
+}
+
+QMap<QString, int>
+Preset::groups() const
+{
+    return p->groups;
+}
+
 bool
 Preset::hasOption(const QString& id) const
 {
@@ -5,6 +5,7 @@
 #pragma once
 
 #include <QList>
+#include <QMap>
 #include <QScopedPointer>
 #include <QString>
 #include <QVariant>
@@ -40,9 +41,33 @@ public:
     QString output;
     QString arguments;
     QString startin;
-    QString dependson;
+    QStringList dependson;
     QStringList documentation;
     QVariant exclusive;
+    QVariant cpuslots;
+    QVariant memory;
+    QStringList groups;
+    QVariant attempts;
+    QVariant delay;
+    QVariant maxdelay;
+    QList<int> exitcodes;
+    QList<int> signalcodes;
+    QStringList patterns;
+    QVariant timeout;
+    QVariant idletimeout;
+    QString chunkunit;
+    QVariant chunkcount;
+    QVariant chunkstart;
+    QVariant chunkend;
+    QString chunkprobe;
+    QVariant batchfiles;
+    QVariant batchbytes;
+    QString batchresponse;
+    QVariant workerjobs;
+    QVariant pipe;
+    QVariant intermediate;
+    QVariant jobserver;
+    QString workerarguments;
 };
 
 class PresetPrivate;
@@ -60,6 +85,10 @@ public:
     QString name() const;
     QString type() const;
     QString filter() const;
+    bool incremental() const;
+    bool cache() const;
+    int weight() const;
+    QMap<QString, int> groups() const;
     bool hasOption(const QString& id) const;
     QSharedPointer<Option> option(const QString& id) const;
     QList<QSharedPointer<Option>> options() const;
@@ -4,13 +4,17 @@
 // https://github.com/mikaelsundell/jobman
 
 #include "process.h"
+#include <errno.h>
+#include <fcntl.h>
 #include <signal.h>
 #include <sys/stat.h>
 #include <unistd.h>
 
 #ifdef __APPLE__
 #    include <crt_externs.h>
+#    include <poll.h>
 #    include <spawn.h>
+#    include <sys/wait.h>
 #endif
 
 #ifdef _WIN32
@@ -19,9 +23,15 @@
 #endif
 
 #include <QDir>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QMutex>
 #include <QProcess>
+#include <QSet>
 #include <QThread>
 
+#include <atomic>
+
 class ProcessPrivate : public QObject {
     Q_OBJECT
 public:
@@ -29,25 +39,46 @@ public:
     ~ProcessPrivate();
     void init();
     void run(const QString& command, const QStringList& arguments, const QString& startin,
-             const QList<QPair<QString, QString>>& environmentvars);
+             const QList<QPair<QString, QString>>& environmentvars, bool interactive = false);
     bool wait();
+    bool write(const QByteArray& data);
+    bool readLine(QByteArray& line, QByteArray& error);
     void kill();
     void kill(int pid);
+    void spawned();
+    void reaped();
+#ifdef __APPLE__
+    bool reap(pid_t child, int& status, bool block);
+#endif
 
 public:
+    static QMutex livemutex;  // guards live and pipes, held while children are reaped
+    static QSet<int> live;  // spawned and not yet reaped, signals by pid never reach a reused pid
+    static QHash<int, int> pipes;  // piped command by command, signalled together
     QString mapCommand(const QString& command);
     char** mapEnvironment(QList<QPair<QString, QString>> environment);
     bool running;
+    bool failed;  // no process was spawned, exitcode is not from the command
     int exitcode;
     QString outputBuffer;
     QString errorBuffer;
+    QElapsedTimer timer;
+    std::atomic<qint64> activity;  // msecs since run at last output, read by the queue watchdog
+    QByteArray pending;  // output read past the last line of an interactive process
+    QString pipecommand;  // reads the output of the command, both run as one process
+    QStringList pipearguments;
 
 #ifdef __APPLE__
     pid_t pid;
+    pid_t pipepid;
+    int inputpipe[2];
     int outputpipe[2];
     int errorpipe[2];
 #elif defined(_WIN32)
     PROCESS_INFORMATION processInfo;
+    PROCESS_INFORMATION pipeInfo;
+    HANDLE inputRead;
+    HANDLE inputWrite;
     HANDLE outputRead;
     HANDLE outputWrite;
     HANDLE errorRead;
@@ -58,17 +89,29 @@ public:
 ProcessPrivate::ProcessPrivate()
     : exitcode(-1)
     , running(false)
+    , failed(false)
+    , activity(0)
 {
 #ifdef __APPLE__
     pid = -1;
+    pipepid = -1;
+    inputpipe[0] = inputpipe[1] = -1;
+    outputpipe[0] = outputpipe[1] = -1;
+    errorpipe[0] = errorpipe[1] = -1;
 #elif defined(_WIN32)
     ZeroMemory(&processInfo, sizeof(PROCESS_INFORMATION));
+    ZeroMemory(&pipeInfo, sizeof(PROCESS_INFORMATION));
+    inputRead = nullptr;
+    inputWrite = nullptr;
 #endif
 }
 
 ProcessPrivate::~ProcessPrivate()
 {
 #ifdef __APPLE__
+    if (inputpipe[1] != -1) {
+        close(inputpipe[1]);
+    }
     if (outputpipe[0] != -1) {
         close(outputpipe[0]);
     }
@@ -78,17 +121,79 @@ ProcessPrivate::~ProcessPrivate()
 #endif
 }
 
+QMutex ProcessPrivate::livemutex;
+QSet<int> ProcessPrivate::live;
+QHash<int, int> ProcessPrivate::pipes;
+
 void
 ProcessPrivate::init()
 {}
 
+void
+ProcessPrivate::spawned()
+{
+    QMutexLocker locker(&livemutex);
+#ifdef __APPLE__
+    live.insert(pid);
+    if (pipepid > 0) {
+        live.insert(pipepid);
+        pipes.insert(pid, pipepid);
+    }
+#elif defined(_WIN32)
+    live.insert(static_cast<int>(processInfo.dwProcessId));
+    if (pipeInfo.hProcess != nullptr) {
+        live.insert(static_cast<int>(pipeInfo.dwProcessId));
+        pipes.insert(static_cast<int>(processInfo.dwProcessId), static_cast<int>(pipeInfo.dwProcessId));
+    }
+#endif
+}
+
+void
+ProcessPrivate::reaped()
+{
+    QMutexLocker locker(&livemutex);
+#ifdef __APPLE__
+    live.remove(pid);
+    live.remove(pipes.take(pid));
+#elif defined(_WIN32)
+    const int processid = static_cast<int>(processInfo.dwProcessId);
+    live.remove(processid);
+    live.remove(pipes.take(processid));  // before the handles close and the pids can be reused
+#endif
+}
+
+#ifdef __APPLE__
+bool
+ProcessPrivate::reap(pid_t child, int& status, bool block)
+{
+    while (true) {
+        {
+            QMutexLocker locker(&livemutex);  // a pid is never signalled between reaping and removal
+            const pid_t result = waitpid(child, &status, WNOHANG);
+            if (result == child || (result < 0 && errno != EINTR)) {
+                live.remove(child);
+                return true;
+            }
+        }
+        if (!block) {
+            return false;
+        }
+        QThread::msleep(10);  // the lock is not held while blocking
+    }
+}
+#endif
+
 void
 ProcessPrivate::run(const QString& command, const QStringList& arguments, const QString& startin,
-                    const QList<QPair<QString, QString>>& environment)
+                    const QList<QPair<QString, QString>>& environment, bool interactive)
 {
     running = false;
+    failed = true;  // until the command, and the piped command, are spawned
     outputBuffer.clear();
     errorBuffer.clear();
+    pending.clear();
+    timer.start();
+    activity = 0;
     QString absolutepath = mapCommand(command);
 
 #ifdef __APPLE__
@@ -106,23 +211,76 @@ ProcessPrivate::run(const QString& command, const QStringList& arguments, const
     if (pipe(outputpipe) == -1 || pipe(errorpipe) == -1) {
         return;  // error creating pipes
     }
-    posix_spawn_file_actions_adddup2(&actions, outputpipe[1], STDOUT_FILENO);
+    int chainpipe[2] = { -1, -1 };
+    const bool piped = !pipecommand.isEmpty();
+    if (piped) {
+        if (pipe(chainpipe) == -1) {
+            return;
+        }
+        posix_spawn_file_actions_addclose(&actions, chainpipe[0]);
+    }
+    posix_spawn_file_actions_adddup2(&actions, piped ? chainpipe[1] : outputpipe[1], STDOUT_FILENO);
     posix_spawn_file_actions_adddup2(&actions, errorpipe[1], STDERR_FILENO);
     posix_spawn_file_actions_addclose(&actions, outputpipe[0]);
     posix_spawn_file_actions_addclose(&actions, errorpipe[0]);
+    if (interactive) {
+        if (pipe(inputpipe) == -1) {
+            return;
+        }
+        fcntl(inputpipe[1], F_SETNOSIGPIPE, 1);  // a crashed worker fails the write instead of the app
+        posix_spawn_file_actions_adddup2(&actions, inputpipe[0], STDIN_FILENO);
+        posix_spawn_file_actions_addclose(&actions, inputpipe[1]);
+    }
     if (!startin.isEmpty()) {
         chdir(startin.toLocal8Bit().data());
     }
     char** environ = mapEnvironment(environment);
     int status = posix_spawn(&pid, commandbytes.data(), &actions, nullptr, argv.data(), environ);
     posix_spawn_file_actions_destroy(&actions);
+    if (piped) {
+        if (status == 0) {
+            // output goes from process to process through the kernel, never through jobman
+            QByteArray pipebytes = mapCommand(pipecommand).toLocal8Bit();
+            std::vector<QByteArray> pipeargbytes { pipebytes };
+            for (const QString& arg : pipearguments) {
+                pipeargbytes.push_back(arg.toLocal8Bit());
+            }
+            QList<char*> pipeargv;
+            for (QByteArray& bytes : pipeargbytes) {
+                pipeargv.push_back(bytes.data());
+            }
+            pipeargv.push_back(nullptr);
+            posix_spawn_file_actions_t pipeactions;
+            posix_spawn_file_actions_init(&pipeactions);
+            posix_spawn_file_actions_adddup2(&pipeactions, chainpipe[0], STDIN_FILENO);
+            posix_spawn_file_actions_adddup2(&pipeactions, outputpipe[1], STDOUT_FILENO);
+            posix_spawn_file_actions_adddup2(&pipeactions, errorpipe[1], STDERR_FILENO);
+            posix_spawn_file_actions_addclose(&pipeactions, chainpipe[1]);
+            posix_spawn_file_actions_addclose(&pipeactions, outputpipe[0]);
+            posix_spawn_file_actions_addclose(&pipeactions, errorpipe[0]);
+            status = posix_spawn(&pipepid, pipebytes.data(), &pipeactions, nullptr, pipeargv.data(), environ);
+            posix_spawn_file_actions_destroy(&pipeactions);
+            if (status != 0) {
+                ::kill(pid, SIGKILL);  // nothing would read its output
+                waitpid(pid, nullptr, 0);
+                pipepid = -1;
+            }
+        }
+        close(chainpipe[0]);
+        close(chainpipe[1]);
+    }
     for (int i = 0; environ[i] != nullptr; ++i) {
         free(environ[i]);  // take care of environ
     }
     close(outputpipe[1]);
     close(errorpipe[1]);
+    if (interactive) {
+        close(inputpipe[0]);
+        inputpipe[0] = -1;
+    }
     if (status == 0) {
         running = true;
+        spawned();
     }
     else {
         exitcode = -1;  // process failed to start
@@ -140,6 +298,13 @@ ProcessPrivate::run(const QString& command, const QStringList& arguments, const
     }
     SetHandleInformation(outputRead, HANDLE_FLAG_INHERIT, 0);
     SetHandleInformation(errorRead, HANDLE_FLAG_INHERIT, 0);
+    if (interactive) {
+        if (!CreatePipe(&inputRead, &inputWrite, &sa, 0)) {
+            exitcode = -1;
+            return;
+        }
+        SetHandleInformation(inputWrite, HANDLE_FLAG_INHERIT, 0);
+    }
 
     QStringList quotedarguments;
     for (const QString& arg : arguments) {
@@ -198,11 +363,23 @@ ProcessPrivate::run(const QString& command, const QStringList& arguments, const
     envblocks.push_back(L'\0');
     LPVOID lpenvironment = const_cast<wchar_t*>(envblocks.c_str());
 
+    HANDLE chainRead = nullptr;
+    HANDLE chainWrite = nullptr;
+    const bool piped = !pipecommand.isEmpty();
+    if (piped) {
+        if (!CreatePipe(&chainRead, &chainWrite, &sa, 0)) {
+            exitcode = -1;
+            return;
+        }
+        SetHandleInformation(chainRead, HANDLE_FLAG_INHERIT, 0);
+    }
+
     STARTUPINFO startupInfo;
     ZeroMemory(&startupInfo, sizeof(STARTUPINFO));
     startupInfo.cb = sizeof(STARTUPINFO);
-    startupInfo.hStdOutput = outputWrite;
+    startupInfo.hStdOutput = piped ? chainWrite : outputWrite;
     startupInfo.hStdError = errorWrite;
+    startupInfo.hStdInput = inputRead;
     startupInfo.dwFlags |= STARTF_USESTDHANDLES | STARTF_USESHOWWINDOW;
     startupInfo.wShowWindow = SW_HIDE;
 
@@ -213,9 +390,44 @@ ProcessPrivate::run(const QString& command, const QStringList& arguments, const
     else {
         exitcode = -1;
     }
+    if (piped) {
+        if (running) {
+            // the write end is not inherited, the piped command sees eof when the first one exits
+            SetHandleInformation(chainRead, HANDLE_FLAG_INHERIT, HANDLE_FLAG_INHERIT);
+            SetHandleInformation(chainWrite, HANDLE_FLAG_INHERIT, 0);
+            QStringList quotedpipearguments;
+            for (const QString& arg : pipearguments) {
+                quotedpipearguments.append(QString("\"%1\"").arg(arg));
+            }
+            std::wstring pipecommandlinew
+                = (mapCommand(pipecommand) + " " + quotedpipearguments.join(" ")).toStdWString();
+            startupInfo.hStdInput = chainRead;
+            startupInfo.hStdOutput = outputWrite;
+            if (!CreateProcessW(nullptr, const_cast<LPWSTR>(pipecommandlinew.c_str()), nullptr, nullptr, TRUE,
+                                CREATE_UNICODE_ENVIRONMENT | CREATE_NO_WINDOW, lpenvironment, nullptr, &startupInfo,
+                                &pipeInfo)) {
+                TerminateProcess(processInfo.hProcess, 1);  // nothing would read its output
+                CloseHandle(processInfo.hProcess);
+                CloseHandle(processInfo.hThread);
+                ZeroMemory(&pipeInfo, sizeof(PROCESS_INFORMATION));
+                running = false;
+                exitcode = -1;
+            }
+        }
+        CloseHandle(chainRead);
+        CloseHandle(chainWrite);
+    }
+    if (running) {
+        spawned();
+    }
     CloseHandle(outputWrite);
     CloseHandle(errorWrite);
+    if (inputRead != nullptr) {
+        CloseHandle(inputRead);
+        inputRead = nullptr;
+    }
 #endif
+    failed = !running;
 }
 
 bool
@@ -223,24 +435,69 @@ ProcessPrivate::wait()
 {
     if (running) {
 #ifdef __APPLE__
-        int status;
-        waitpid(pid, &status, 0);
+        // pipes are read while the process runs, output drives the idle timeout and a full
+        // pipe can not block the process
+        if (inputpipe[1] != -1) {
+            close(inputpipe[1]);  // end of requests, a worker exits on eof
+            inputpipe[1] = -1;
+        }
+        int status = 0;
+        int pipestatus = 0;
+        bool exited = false;
+        bool pipeexited = pipepid <= 0;
+        char buffer[4096];
+        QByteArray output;
+        QByteArray error;
+        struct pollfd fds[2] = { { outputpipe[0], POLLIN, 0 }, { errorpipe[0], POLLIN, 0 } };
+        int open = (outputpipe[0] != -1) + (errorpipe[0] != -1);
+        while (open > 0) {
+            int ready = poll(fds, 2, exited ? 0 : 100);
+            if (ready < 0 && errno != EINTR) {
+                break;
+            }
+            if (ready == 0 && exited && pipeexited) {
+                break;  // drained, pipes kept open by a detached child are not waited for
+            }
+            for (struct pollfd& fd : fds) {
+                if (fd.fd == -1 || ready <= 0 || !(fd.revents & (POLLIN | POLLHUP | POLLERR))) {
+                    continue;
+                }
+                ssize_t bytesread = read(fd.fd, buffer, sizeof(buffer));
+                if (bytesread > 0) {
+                    (fd.fd == outputpipe[0] ? output : error).append(buffer, bytesread);
+                    activity = timer.elapsed();
+                }
+                else if (bytesread == 0 || errno != EINTR) {
+                    fd.fd = -1;
+                    open--;
+                }
+            }
+            if (!exited && reap(pid, status, false)) {
+                exited = true;
+            }
+            if (!pipeexited && reap(pipepid, pipestatus, false)) {
+                pipeexited = true;
+            }
+        }
+        if (!exited) {
+            reap(pid, status, true);
+        }
+        if (!pipeexited) {
+            reap(pipepid, pipestatus, true);
+        }
+        if (pipepid > 0 && WIFEXITED(status) && WEXITSTATUS(status) == 0) {
+            status = pipestatus;  // a pipeline fails when any of its commands fails
+        }
+        reaped();
+        pipepid = -1;
         running = false;
-        char buffer[1024];
-        ssize_t bytesread;
+        outputBuffer.append(QString::fromLocal8Bit(pending + output));
+        errorBuffer.append(QString::fromLocal8Bit(error));
         if (outputpipe[0] != -1) {
-            while ((bytesread = read(outputpipe[0], buffer, sizeof(buffer) - 1)) > 0) {
-                buffer[bytesread] = '\0';
-                outputBuffer.append(buffer);
-            }
             close(outputpipe[0]);
             outputpipe[0] = -1;
         }
         if (errorpipe[0] != -1) {
-            while ((bytesread = read(errorpipe[0], buffer, sizeof(buffer) - 1)) > 0) {
-                buffer[bytesread] = '\0';
-                errorBuffer.append(buffer);
-            }
             close(errorpipe[0]);
             errorpipe[0] = -1;
         }
@@ -261,10 +518,21 @@ ProcessPrivate::wait()
             DWORD bytesRead;
             BOOL success;
             DWORD exitCode;
+            if (inputWrite != nullptr) {
+                CloseHandle(inputWrite);  // end of requests, a worker exits on eof
+                inputWrite = nullptr;
+            }
+            outputBuffer.append(QString::fromLocal8Bit(pending));
             while (true) {
                 DWORD status = WaitForSingleObject(processInfo.hProcess, 50);
+                if (status == WAIT_OBJECT_0 && pipeInfo.hProcess != nullptr) {
+                    status = WaitForSingleObject(pipeInfo.hProcess, 0);  // a pipeline ends with its last command
+                }
                 if (status == WAIT_OBJECT_0) {
                     GetExitCodeProcess(processInfo.hProcess, &exitCode);
+                    if (exitCode == 0 && pipeInfo.hProcess != nullptr) {
+                        GetExitCodeProcess(pipeInfo.hProcess, &exitCode);
+                    }
                     exitcode = exitCode;
                     running = false;
                 }
@@ -280,6 +548,7 @@ ProcessPrivate::wait()
                     }
                     buffer[bytesRead] = '\0';
                     outputBuffer.append(QString::fromLocal8Bit(buffer));
+                    activity = timer.elapsed();
                 }
                 while (true) {
                     DWORD bytesAvailable = 0;
@@ -293,16 +562,23 @@ ProcessPrivate::wait()
                     }
                     buffer[bytesRead] = '\0';
                     errorBuffer.append(QString::fromLocal8Bit(buffer));
+                    activity = timer.elapsed();
                 }
                 if (!running) {
                     break;
                 }
                 QThread::msleep(10);
             }
+            reaped();
             CloseHandle(outputRead);
             CloseHandle(errorRead);
             CloseHandle(processInfo.hProcess);
             CloseHandle(processInfo.hThread);
+            if (pipeInfo.hProcess != nullptr) {
+                CloseHandle(pipeInfo.hProcess);
+                CloseHandle(pipeInfo.hThread);
+                ZeroMemory(&pipeInfo, sizeof(PROCESS_INFORMATION));
+            }
             return exitcode == 0;
         }
 #endif
@@ -316,12 +592,108 @@ ProcessPrivate::kill()
 #ifdef __APPLE__
     if (running) {
         ::kill(pid, SIGKILL);
+        if (pipepid > 0) {
+            ::kill(pipepid, SIGKILL);
+        }
         wait();
     }
 #elif defined(_WIN32)
-    TerminateProcess(processInfo.hProcess, 1);
-    CloseHandle(processInfo.hProcess);
+    if (running) {
+        TerminateProcess(processInfo.hProcess, 1);
+        if (pipeInfo.hProcess != nullptr) {
+            TerminateProcess(pipeInfo.hProcess, 1);
+        }
+        wait();  // closes pipes and handles
+    }
+#endif
+}
+
+bool
+ProcessPrivate::write(const QByteArray& data)
+{
+    if (!running) {
+        return false;
+    }
+#ifdef __APPLE__
+    qint64 written = 0;
+    while (written < data.size()) {
+        ssize_t bytes = ::write(inputpipe[1], data.constData() + written, data.size() - written);
+        if (bytes < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        written += bytes;
+    }
+    return true;
+#elif defined(_WIN32)
+    DWORD written = 0;
+    return WriteFile(inputWrite, data.constData(), static_cast<DWORD>(data.size()), &written, nullptr)
+           && written == static_cast<DWORD>(data.size());
+#endif
+}
+
+bool
+ProcessPrivate::readLine(QByteArray& line, QByteArray& error)
+{
+    // blocks until a line is read from output, false when the process closed its output
+    while (running) {
+        const int index = pending.indexOf('\n');
+        if (index >= 0) {
+            line = pending.left(index);
+            if (line.endsWith('\r')) {
+                line.chop(1);
+            }
+            pending.remove(0, index + 1);
+            return true;
+        }
+#ifdef __APPLE__
+        char buffer[4096];
+        struct pollfd fds[2] = { { outputpipe[0], POLLIN, 0 }, { errorpipe[0], POLLIN, 0 } };
+        int ready = poll(fds, 2, 100);
+        if (ready < 0 && errno != EINTR) {
+            return false;
+        }
+        for (struct pollfd& fd : fds) {
+            if (fd.fd == -1 || ready <= 0 || !(fd.revents & (POLLIN | POLLHUP | POLLERR))) {
+                continue;
+            }
+            ssize_t bytesread = read(fd.fd, buffer, sizeof(buffer));
+            if (bytesread > 0) {
+                (fd.fd == outputpipe[0] ? pending : error).append(buffer, bytesread);
+                activity = timer.elapsed();
+            }
+            else if (bytesread == 0 || errno != EINTR) {
+                if (fd.fd == outputpipe[0]) {
+                    return false;  // exited or crashed, reaped by wait
+                }
+                close(errorpipe[0]);
+                errorpipe[0] = -1;
+            }
+        }
+#elif defined(_WIN32)
+        char buffer[1024];
+        DWORD bytesRead = 0;
+        bool available = false;
+        for (HANDLE handle : { outputRead, errorRead }) {
+            DWORD bytesAvailable = 0;
+            if (PeekNamedPipe(handle, nullptr, 0, nullptr, &bytesAvailable, nullptr) && bytesAvailable > 0
+                && ReadFile(handle, buffer, sizeof(buffer), &bytesRead, nullptr) && bytesRead > 0) {
+                (handle == outputRead ? pending : error).append(buffer, bytesRead);
+                activity = timer.elapsed();
+                available = true;
+            }
+        }
+        if (!available) {
+            if (WaitForSingleObject(processInfo.hProcess, 0) == WAIT_OBJECT_0) {
+                return false;  // exited or crashed, reaped by wait
+            }
+            QThread::msleep(10);
+        }
 #endif
+    }
+    return false;
 }
 
 QString
@@ -396,12 +768,60 @@ Process::run(const QString& command, const QStringList& arguments, const QString
     p->run(command, arguments, startin, environmentvars);
 }
 
+void
+Process::start(const QString& command, const QStringList& arguments, const QString& startin,
+               const QList<QPair<QString, QString>>& environmentvars)
+{
+    p->run(command, arguments, startin, environmentvars, true);
+}
+
 bool
 Process::wait()
 {
     return p->wait();
 }
 
+void
+Process::setPipe(const QString& command, const QStringList& arguments)
+{
+    p->pipecommand = command;
+    p->pipearguments = arguments;
+}
+
+bool
+Process::write(const QByteArray& data)
+{
+    p->timer.start();  // elapsed and idle count from the last request of a started process
+    p->activity = 0;
+    return p->write(data);
+}
+
+bool
+Process::readLine(QByteArray& line, QByteArray& error)
+{
+    return p->readLine(line, error);
+}
+
+bool
+Process::isRunning() const
+{
+    if (!p->running) {
+        return false;
+    }
+#ifdef __APPLE__
+    siginfo_t info = {};
+    return waitid(P_PID, p->pid, &info, WEXITED | WNOHANG | WNOWAIT) == 0 && info.si_pid == 0;  // reaped by wait
+#elif defined(_WIN32)
+    return WaitForSingleObject(p->processInfo.hProcess, 0) == WAIT_TIMEOUT;
+#endif
+}
+
+bool
+Process::failedToStart() const
+{
+    return p->failed;
+}
+
 bool
 Process::exists(const QString& command)
 {
@@ -436,6 +856,18 @@ Process::pid() const
 #endif
 }
 
+qint64
+Process::elapsed() const
+{
+    return p->timer.isValid() ? p->timer.elapsed() : 0;
+}
+
+qint64
+Process::idle() const
+{
+    return p->timer.isValid() ? p->timer.elapsed() - p->activity : 0;
+}
+
 QString
 Process::standardOutput() const
 {
@@ -463,13 +895,34 @@ Process::exitStatus() const
 void
 Process::kill(int pid)
 {
+    QMutexLocker locker(&ProcessPrivate::livemutex);  // the command and its piped command, while not reaped
+    for (int child : { pid, ProcessPrivate::pipes.value(pid, -1) }) {
+        if (!ProcessPrivate::live.contains(child)) {
+            continue;
+        }
 #ifdef __APPLE__
-    ::kill(pid, SIGKILL);
+        ::kill(child, SIGKILL);
 #elif defined(_WIN32)
-    HANDLE hProcess = OpenProcess(PROCESS_TERMINATE, FALSE, static_cast<DWORD>(pid));
-    if (hProcess != nullptr) {
-        TerminateProcess(hProcess, 1);  // Exit code 1 for forced termination
-        CloseHandle(hProcess);
+        HANDLE hProcess = OpenProcess(PROCESS_TERMINATE, FALSE, static_cast<DWORD>(child));
+        if (hProcess != nullptr) {
+            TerminateProcess(hProcess, 1);  // Exit code 1 for forced termination
+            CloseHandle(hProcess);
+        }
+#endif
     }
+}
+
+void
+Process::terminate(int pid)
+{
+#ifdef __APPLE__
+    QMutexLocker locker(&ProcessPrivate::livemutex);
+    for (int child : { pid, ProcessPrivate::pipes.value(pid, -1) }) {
+        if (ProcessPrivate::live.contains(child)) {
+            ::kill(child, SIGTERM);
+        }
+    }
+#elif defined(_WIN32)
+    kill(pid);  // no console to signal, terminate is forced
 #endif
 }
@@ -19,10 +19,19 @@ public:
     virtual ~Process();
     void run(const QString& command, const QStringList& arguments, const QString& startin = QString(),
              const QList<QPair<QString, QString>>& environmentvars = QList<QPair<QString, QString>>());
+    void start(const QString& command, const QStringList& arguments, const QString& startin = QString(),
+               const QList<QPair<QString, QString>>& environmentvars = QList<QPair<QString, QString>>());
     bool wait();
+    void setPipe(const QString& command, const QStringList& arguments);
+    bool write(const QByteArray& data);
+    bool readLine(QByteArray& line, QByteArray& error);
+    bool isRunning() const;
+    bool failedToStart() const;
     bool exists(const QString& command);
     void kill();
     int pid() const;
+    qint64 elapsed() const;
+    qint64 idle() const;
     QString standardOutput() const;
     QString standardError() const;
     int exitCode() const;
@@ -30,6 +39,7 @@ public:
 
 public:
     static void kill(int pid);
+    static void terminate(int pid);
 
 private:
     QScopedPointer<ProcessPrivate> p;
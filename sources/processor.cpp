@@ -4,16 +4,31 @@
 
 #include "processor.h"
 #include "job.h"
+#include "process.h"
 #include "queue.h"
 #include "utils.h"
 
+#include <QDir>
+#include <QFile>
 #include <QFileInfo>
 #include <QPointer>
+#include <QSet>
 #include <QSettings>
 #include <QUuid>
 
+#include <algorithm>
+
 class ProcessorPrivate : public QObject {
     Q_OBJECT
+public:
+    struct Chunk {
+        int index = -1;  // not chunked
+        int count = 1;
+        QString start;
+        QString end;
+        bool failed = false;  // length of the input unknown
+    };
+
 public:
     ProcessorPrivate();
     void init();
@@ -22,10 +37,27 @@ public:
 
 public:
     QString updatePaths(const QString& input, const QString& pattern, const QFileInfo& inputinfo);
-    QString updateFiles(const QString& input, const QFileInfo& inputinfo, const QFileInfo& outputinfo);
+    QString updateFiles(const QString& input, const QFileInfo& inputinfo, const QFileInfo& outputinfo,
+                        const QString& scratchdir);
     QString updateTask(const QString& input, const QString& inputinfo, const QString& outputinfo);
+    QStringList updateInputs(const QStringList& arguments, const QStringList& dependentids,
+                             const QMap<QString, QStringList>& joboutputs);
+    QList<Chunk> updateChunks(const QSharedPointer<Task>& task, const QFileInfo& inputinfo, const QStringList& probe);
+    QString updateChunkOutput(const QSharedPointer<Task>& task, const QString& output);
+    QString updateChunk(const QString& input, const Chunk& chunk);
+    QStringList updateChunk(const QStringList& input, const Chunk& chunk);
+    QList<QSharedPointer<Job>> updateBatches(const QList<QSharedPointer<Job>>& jobs,
+                                             const QSharedPointer<Preset>& preset, const Paths& paths);
+    QSharedPointer<Job> updateBatch(const QSharedPointer<Task>& task, const QList<QSharedPointer<Job>>& members);
+    bool isUpToDate(const QSharedPointer<Job>& job);
     QStringList updateOptions(QList<QSharedPointer<Option>> options, const QString& input);
     void updateEnvironment(QSharedPointer<Job> job, const Paths& paths);
+    QMap<QString, int> updateGroups(const QSharedPointer<Preset>& preset, const QSharedPointer<Task>& task);
+    Retry updateRetry(const QSharedPointer<Task>& task);
+    Worker updateWorker(const QSharedPointer<Task>& task);
+    QString updateScratch();
+    void updatePipe(const QSharedPointer<Job>& job, const QSharedPointer<Preset>& preset,
+                    const QList<QSharedPointer<Job>>& jobs);
 
     QPointer<Queue> queue;
     QPointer<Processor> object;
@@ -43,12 +75,25 @@ QList<QUuid>
 ProcessorPrivate::submit(const QList<QString>& files, const QSharedPointer<Preset>& preset, const Paths& paths)
 {
     QList<QUuid> uuids;
-    QUuid batchuuid = queue->beginBatch();
+    QUuid batchuuid = QUuid::createUuid();
+    queue->beginBatchAsync(batchuuid);  // queued calls run in order, no round trips
+    QMap<QString, Retry> retries;
+    int batchfiles = 0;  // files grouped before batched tasks are submitted, zero when not batched
+    for (QSharedPointer<Task> task : preset->tasks()) {
+        retries[task->id] = updateRetry(task);
+        if (task->batchfiles.toInt() > 0) {
+            batchfiles = batchfiles ? qMin(batchfiles, task->batchfiles.toInt()) : task->batchfiles.toInt();
+        }
+    }
+    QList<QSharedPointer<Job>> batchjobs;
+    int batchcount = 0;
     for (const QString& file : files) {
-        QMap<QString, QUuid> jobuuids;
-        QMap<QString, QString> joboutputs;
-        QList<QPair<QSharedPointer<Job>, QString>> dependentjobs;
+        QList<QSharedPointer<Job>> jobs;
+        QMap<QString, QList<QUuid>> jobuuids;
+        QMap<QString, QStringList> joboutputs;
+        QList<QPair<QSharedPointer<Job>, QStringList>> dependentjobs;
         QFileInfo inputinfo(file);
+        const QString scratchdir = updateScratch();
         bool first = true;
         for (QSharedPointer<Task> task : preset->tasks()) {
             QString extension = updatePaths(task->extension, "input", inputinfo);
@@ -59,67 +104,112 @@ ProcessorPrivate::submit(const QList<QString>& files, const QSharedPointer<Prese
             else {
                 outputdir = paths.outputpath;
             }
+            if (task->intermediate.toBool()) {
+                outputdir = scratchdir;  // read back by dependents, kept off the save to volume
+            }
             QString outputfile = outputdir + "/" + inputinfo.completeBaseName() + "." + extension;
             QFileInfo outputinfo(outputfile);
-            QString command
-                = updateOptions(preset->options(), updateFiles(task->command, inputinfo, outputinfo)).join(" ");
-            QString output
-                = updateOptions(preset->options(), updateFiles(task->output, inputinfo, outputinfo)).join(" ");
+            QString command = updateOptions(preset->options(),
+                                            updateFiles(task->command, inputinfo, outputinfo, scratchdir))
+                                  .join(" ");
+            QString output = updateChunkOutput(
+                task, updateOptions(preset->options(), updateFiles(task->output, inputinfo, outputinfo, scratchdir))
+                          .join(" "));
             QStringList argumentlist = task->arguments.split(" ");
             QStringList replacedlist;
             for (QString& argument : argumentlist) {
-                replacedlist.append(
-                    updateOptions(preset->options(),
-                                  updateTask("output", updateFiles(argument, inputinfo, outputinfo), output)));
+                replacedlist.append(updateOptions(
+                    preset->options(),
+                    updateTask("output", updateFiles(argument, inputinfo, outputinfo, scratchdir), output)));
             }
-            QString startin
-                = updateOptions(preset->options(), updateFiles(task->startin, inputinfo, outputinfo)).join(" ");
-            // job
-            QSharedPointer<Job> job(new Job());
-            {
-                job->setId(task->id);
-                job->setFilename(inputinfo.filePath());
-                job->setDir(outputdir);
-                job->setName(task->name);
-                job->setCommand(command);
-                job->setArguments(replacedlist);
-                job->setOutput(output);
-                job->setExclusive(task->exclusive.toBool());
-                job->setOverwrite(paths.overwrite);
-                job->setStartin(startin);
-                job->setStatus(Job::Waiting);
+            QString startin = updateOptions(preset->options(),
+                                            updateFiles(task->startin, inputinfo, outputinfo, scratchdir))
+                                  .join(" ");
+            QStringList probe;
+            for (const QString& argument : task->chunkprobe.split(" ", Qt::SkipEmptyParts)) {
+                probe.append(
+                    updateOptions(preset->options(), updateFiles(argument, inputinfo, outputinfo, scratchdir)));
             }
-            updateEnvironment(job, paths);
-
-            if (first) {
-                if (paths.copyoriginal) {
-                    job->preprocess().copyoriginal.filename = file;
+            if (!probe.isEmpty() && !QFileInfo(probe.first()).isAbsolute()) {
+                QSettings settings(APP_IDENTIFIER, APP_NAME);  // resolved like job commands
+                for (const QString& searchpath : settings.value("searchpaths", paths.searchpaths).toStringList()) {
+                    const QString filepath = QDir::cleanPath(QDir(searchpath).filePath(probe.first()));
+                    if (QFile::exists(filepath)) {
+                        probe.first() = filepath;
+                        break;
+                    }
                 }
-                first = false;
             }
-            if (task->dependson.isEmpty()) {
-                QUuid uuid = queue->submit(job, batchuuid);
-                jobuuids[task->id] = uuid;
-                uuids.append(uuid);
-            }
-            else {
-                dependentjobs.append(qMakePair(job, task->dependson));
+            // job, one per chunk
+            for (const Chunk& chunk : updateChunks(task, inputinfo, probe)) {
+                QSharedPointer<Job> job(new Job());
+                {
+                    job->setId(task->id);
+                    job->setPreset(preset->id());
+                    job->setFilename(inputinfo.filePath());
+                    job->setDir(outputdir);
+                    job->setName(task->name);
+                    job->setCommand(command);
+                    job->setArguments(updateChunk(replacedlist, chunk));
+                    job->setOutput(updateChunk(output, chunk));
+                    job->setExclusive(task->exclusive.toBool());
+                    job->setCpuslots(task->cpuslots.toInt());
+                    job->setMemory(task->memory.toLongLong());
+                    job->setGroups(updateGroups(preset, task));
+                    job->setOverwrite(paths.overwrite);
+                    job->setIncremental(preset->incremental());
+                    job->setIntermediate(task->intermediate.toBool());
+                    job->setJobserver(task->jobserver.toBool());
+                    job->setCache(preset->cache());
+                    job->setWeight(preset->weight());
+                    job->setTimeout(task->timeout.toInt());
+                    job->setIdletimeout(task->idletimeout.toInt());
+                    job->setStartin(startin);
+                    job->setStatus(Job::Waiting);
+                }
+                if (chunk.failed) {
+                    QString status = QString("Status:\n"
+                                             "Chunk length could not be probed for job: %1\n")
+                                         .arg(job->name());
+                    job->setLog(status);
+                    job->setStatus(Job::Failed);
+                }
+                updateEnvironment(job, paths);
+                job->retry() = retries[task->id];
+                job->worker() = updateWorker(task);
+
+                if (first) {
+                    if (paths.copyoriginal) {
+                        job->preprocess().copyoriginal.filename = file;
+                    }
+                    first = false;
+                }
+                if (task->dependson.isEmpty()) {
+                    jobs.append(job);
+                    jobuuids[task->id].append(job->uuid());
+                    uuids.append(job->uuid());
+                }
+                else {
+                    dependentjobs.append(qMakePair(job, task->dependson));
+                }
+                joboutputs[task->id].append(job->output());
             }
-            joboutputs[task->id] = job->output();
         }
-        for (QPair<QSharedPointer<Job>, QString> depedentjob : dependentjobs) {
+        for (QPair<QSharedPointer<Job>, QStringList> depedentjob : dependentjobs) {
             QSharedPointer<Job> job = depedentjob.first;
-            QString dependentid = depedentjob.second;
-            if (jobuuids.contains(dependentid)) {
-                QStringList argumentlist = job->arguments();
-                for (QString& argument : argumentlist) {
-                    argument = updateTask("input", argument, joboutputs[dependentid]);
+            QStringList dependentids = depedentjob.second;
+            if (std::all_of(dependentids.begin(), dependentids.end(),
+                            [&](const QString& dependentid) { return jobuuids.contains(dependentid); })) {
+                job->setArguments(updateInputs(job->arguments(), dependentids, joboutputs));
+                QList<QUuid> dependson;
+                for (const QString& dependentid : dependentids) {
+                    dependson.append(jobuuids[dependentid]);
                 }
-                job->setArguments(argumentlist);
-                job->setDependson(jobuuids[dependentid]);
-                QUuid uuid = queue->submit(job, batchuuid);
-                jobuuids[job->id()] = uuid;
-                uuids.append(uuid);
+                job->setDependson(dependson);
+                updatePipe(job, preset, jobs);
+                jobs.append(job);
+                jobuuids[job->id()].append(job->uuid());
+                uuids.append(job->uuid());
             }
             else {
                 QString status = QString("Status:\n"
@@ -127,12 +217,28 @@ ProcessorPrivate::submit(const QList<QString>& files, const QSharedPointer<Prese
                                      .arg(job->name());
                 job->setLog(status);
                 job->setStatus(Job::Failed);
+                queue->submitAsync(batchjobs + jobs, batchuuid);
+                queue->endBatchAsync(batchuuid);
                 return uuids;
             }
         }
+        if (batchfiles > 0) {
+            batchjobs.append(jobs);
+            if (++batchcount >= batchfiles) {
+                queue->submitAsync(updateBatches(batchjobs, preset, paths), batchuuid);
+                batchjobs.clear();
+                batchcount = 0;
+            }
+        }
+        else {
+            queue->submitAsync(jobs, batchuuid);
+        }
         object->fileSubmitted(file);
     }
-    queue->endBatch(batchuuid);
+    if (!batchjobs.isEmpty()) {
+        queue->submitAsync(updateBatches(batchjobs, preset, paths), batchuuid);
+    }
+    queue->endBatchAsync(batchuuid);
     return uuids;
 }
 
@@ -141,10 +247,12 @@ QList<QUuid>
 ProcessorPrivate::submit(const QSharedPointer<Preset>& preset, const Paths& paths)
 {
     QList<QUuid> uuids;
-    QMap<QString, QUuid> jobuuids;
-    QMap<QString, QString> joboutputs;
-    QList<QPair<QSharedPointer<Job>, QString>> dependentjobs;
+    QList<QSharedPointer<Job>> jobs;
+    QMap<QString, QList<QUuid>> jobuuids;
+    QMap<QString, QStringList> joboutputs;
+    QList<QPair<QSharedPointer<Job>, QStringList>> dependentjobs;
     QFileInfo inputinfo;
+    const QString scratchdir = updateScratch();
     bool first = true;
     for (QSharedPointer<Task> task : preset->tasks()) {
         if (first) {
@@ -158,59 +266,81 @@ ProcessorPrivate::submit(const QSharedPointer<Preset>& preset, const Paths& path
         else {
             outputdir = paths.outputpath;
         }
+        if (task->intermediate.toBool()) {
+            outputdir = scratchdir;  // read back by dependents, kept off the save to volume
+        }
 
         QString outputfile = outputdir + "/" + inputinfo.completeBaseName() + "." + extension;
         QFileInfo outputinfo(outputfile);
-        QString command = updateOptions(preset->options(), updateFiles(task->command, inputinfo, outputinfo)).join(" ");
-        QString output = updateOptions(preset->options(), updateFiles(task->output, inputinfo, outputinfo)).join(" ");
+        QString command
+            = updateOptions(preset->options(), updateFiles(task->command, inputinfo, outputinfo, scratchdir)).join(" ");
+        QString output
+            = updateOptions(preset->options(), updateFiles(task->output, inputinfo, outputinfo, scratchdir)).join(" ");
         QStringList argumentlist = task->arguments.split(" ");
         QStringList replacedlist;
         for (QString& argument : argumentlist) {
             replacedlist.append(
                 updateOptions(preset->options(),
-                              updateTask("output", updateFiles(argument, inputinfo, outputinfo), output)));
+                              updateTask("output", updateFiles(argument, inputinfo, outputinfo, scratchdir), output)));
         }
-        QString startin = updateOptions(preset->options(), updateFiles(task->startin, inputinfo, outputinfo)).join(" ");
+        QString startin
+            = updateOptions(preset->options(), updateFiles(task->startin, inputinfo, outputinfo, scratchdir)).join(" ");
 
         // job
         QSharedPointer<Job> job(new Job());
         {
             job->setId(task->id);
+            job->setPreset(preset->id());
             job->setFilename(inputinfo.filePath());
             job->setDir(outputdir);
             job->setName(task->name);
             job->setCommand(command);
             job->setArguments(replacedlist);
             job->setOutput(output);
+            job->setCpuslots(task->cpuslots.toInt());
+            job->setMemory(task->memory.toLongLong());
+            job->setGroups(updateGroups(preset, task));
             job->setOverwrite(paths.overwrite);
+            job->setIncremental(preset->incremental());
+            job->setIntermediate(task->intermediate.toBool());
+            job->setJobserver(task->jobserver.toBool());
+            job->setCache(preset->cache());
+            job->setWeight(preset->weight());
+            job->setTimeout(task->timeout.toInt());
+            job->setIdletimeout(task->idletimeout.toInt());
             job->setStartin(startin);
             job->setStatus(Job::Waiting);
         }
         updateEnvironment(job, paths);
+        job->retry() = updateRetry(task);
+        job->worker() = updateWorker(task);
 
         if (task->dependson.isEmpty()) {
-            QUuid uuid = queue->submit(job);
-            jobuuids[task->id] = uuid;
-            joboutputs[task->id] = job->output();
-            uuids.append(uuid);
+            jobs.append(job);
+            jobuuids[task->id].append(job->uuid());
+            joboutputs[task->id].append(job->output());
+            uuids.append(job->uuid());
         }
         else {
             dependentjobs.append(qMakePair(job, task->dependson));
         }
     }
-    for (QPair<QSharedPointer<Job>, QString> depedentjob : dependentjobs) {
+    for (QPair<QSharedPointer<Job>, QStringList> depedentjob : dependentjobs) {
         QSharedPointer<Job> job = depedentjob.first;
-        QString dependentid = depedentjob.second;
-        if (jobuuids.contains(dependentid)) {
-            QStringList argumentlist = job->arguments();
-            for (QString& argument : argumentlist) {
-                argument = updateTask("input", argument, joboutputs[dependentid]);
+        QStringList dependentids = depedentjob.second;
+        if (std::all_of(dependentids.begin(), dependentids.end(),
+                        [&](const QString& dependentid) { return jobuuids.contains(dependentid); })) {
+            job->setArguments(updateInputs(job->arguments(), dependentids, joboutputs));
+            QList<QUuid> dependson;
+            for (const QString& dependentid : dependentids) {
+                dependson.append(jobuuids[dependentid]);
             }
-            job->setArguments(argumentlist);
-            job->setDependson(jobuuids[dependentid]);
-            QUuid uuid = queue->submit(job);
-            jobuuids[job->id()] = uuid;
-            uuids.append(uuid);
+            job->setDependson(dependson);
+            updatePipe(job, preset, jobs);
+            jobs.append(job);
+            jobuuids[job->id()].append(job->uuid());
+            joboutputs[job->id()].append(job->output());
+            uuids.append(job->uuid());
         }
         else {
             QString status = QString("Status:\n"
@@ -218,9 +348,10 @@ ProcessorPrivate::submit(const QSharedPointer<Preset>& preset, const Paths& path
                                  .arg(job->name());
             job->setLog(status);
             job->setStatus(Job::Failed);
-            return uuids;
+            break;
         }
     }
+    queue->submitAsync(jobs);
     return uuids;
 }
 
@@ -239,9 +370,10 @@ ProcessorPrivate::updatePaths(const QString& input, const QString& pattern, cons
 }
 
 QString
-ProcessorPrivate::updateFiles(const QString& input, const QFileInfo& inputinfo, const QFileInfo& outputinfo)
+ProcessorPrivate::updateFiles(const QString& input, const QFileInfo& inputinfo, const QFileInfo& outputinfo,
+                              const QString& scratchdir)
 {
-    return updatePaths(updatePaths(input, "input", inputinfo), "output", outputinfo);
+    return updatePaths(updatePaths(input, "input", inputinfo), "output", outputinfo).replace("%scratch%", scratchdir);
 }
 
 QString
@@ -252,6 +384,285 @@ ProcessorPrivate::updateTask(const QString& input, const QString& inputinfo, con
     return result;
 }
 
+QStringList
+ProcessorPrivate::updateInputs(const QStringList& arguments, const QStringList& dependentids,
+                               const QMap<QString, QStringList>& joboutputs)
+{
+    QStringList result;
+    for (QString argument : arguments) {
+        QStringList inputs = joboutputs.value(dependentids.first());  // first dependson
+        bool expand = argument == "%task:input%";
+        for (const QString& dependentid : dependentids) {
+            const QString input = QString("input:%1").arg(dependentid);
+            if (argument == QString("%task:%1%").arg(input)) {
+                inputs = joboutputs.value(dependentid);
+                expand = true;
+                break;
+            }
+            argument = updateTask(input, argument, joboutputs.value(dependentid).value(0));
+        }
+        if (expand) {
+            result.append(inputs);  // one argument per output, a chunked task has several
+        }
+        else {
+            result.append(updateTask("input", argument, inputs.value(0)));
+        }
+    }
+    return result;
+}
+
+QList<ProcessorPrivate::Chunk>
+ProcessorPrivate::updateChunks(const QSharedPointer<Task>& task, const QFileInfo& inputinfo, const QStringList& probe)
+{
+    if (task->chunkunit.isEmpty()) {
+        return QList<Chunk> { Chunk() };
+    }
+    const bool bytes = task->chunkunit == "bytes";
+    const bool integral = task->chunkunit != "seconds";
+    const double start = task->chunkstart.toDouble();
+    bool known = bytes || !task->chunkend.isNull();
+    double end = (bytes && task->chunkend.isNull()) ? inputinfo.size() : task->chunkend.toDouble();
+    if (!probe.isEmpty()) {
+        Process process;  // length of this input, end is the fallback when the probe fails
+        process.run(probe.first(), probe.mid(1));
+        process.wait();  // run returns once spawned, output and exit code are read after it exits
+        bool ok = false;
+        const double length = process.standardOutput().trimmed().toDouble(&ok);
+        if (!process.failedToStart() && process.exitCode() == 0 && ok && length >= start) {
+            end = length;
+            known = true;
+        }
+    }
+    if (!known) {
+        Chunk chunk;
+        chunk.index = 0;
+        chunk.start = chunk.end = QString::number(start);
+        chunk.failed = true;
+        return QList<Chunk> { chunk };
+    }
+    int count = task->chunkcount.toInt();
+    if (count < 1) {
+        count = qMax(1, queue->snapshot()->threads / qMax(1, task->cpuslots.toInt()));  // fill the machine
+    }
+    if (integral) {
+        count = static_cast<int>(qBound<qint64>(1, static_cast<qint64>(end - start), count));
+    }
+    QList<Chunk> chunks;
+    for (int i = 0; i < count; ++i) {
+        const double chunkstart = start + (end - start) * i / count;
+        const double chunkend = start + (end - start) * (i + 1) / count;
+        Chunk chunk;
+        chunk.index = i;
+        chunk.count = count;
+        chunk.start = integral ? QString::number(static_cast<qint64>(chunkstart)) : QString::number(chunkstart, 'f', 3);
+        chunk.end = integral ? QString::number(static_cast<qint64>(chunkend)) : QString::number(chunkend, 'f', 3);
+        chunks.append(chunk);
+    }
+    return chunks;
+}
+
+QString
+ProcessorPrivate::updateChunkOutput(const QSharedPointer<Task>& task, const QString& output)
+{
+    if (task->chunkunit.isEmpty()) {
+        return output;
+    }
+    QFileInfo outputinfo(output);  // chunks write base.index.ext next to each other
+    const QString suffix = outputinfo.suffix().isEmpty() ? QString() : "." + outputinfo.suffix();
+    return QDir(outputinfo.path())  // single pass arg, base names may contain %2
+        .filePath(QString("%1.%chunk:index%%2").arg(outputinfo.completeBaseName(), suffix));
+}
+
+QString
+ProcessorPrivate::updateChunk(const QString& input, const Chunk& chunk)
+{
+    if (chunk.index < 0) {
+        return input;
+    }
+    QString result = input;
+    result.replace("%chunk:index%", QString::number(chunk.index));
+    result.replace("%chunk:count%", QString::number(chunk.count));
+    result.replace("%chunk:start%", chunk.start);
+    result.replace("%chunk:end%", chunk.end);
+    return result;
+}
+
+QStringList
+ProcessorPrivate::updateChunk(const QStringList& input, const Chunk& chunk)
+{
+    QStringList result;
+    for (const QString& value : input) {
+        result.append(updateChunk(value, chunk));
+    }
+    return result;
+}
+
+QList<QSharedPointer<Job>>
+ProcessorPrivate::updateBatches(const QList<QSharedPointer<Job>>& jobs, const QSharedPointer<Preset>& preset,
+                                const Paths& paths)
+{
+    QList<QSharedPointer<Job>> result;  // task by task, batched jobs before their members
+    for (QSharedPointer<Task> task : preset->tasks()) {
+        QList<QSharedPointer<Job>> taskjobs;
+        for (const QSharedPointer<Job>& job : jobs) {
+            if (job->id() == task->id) {
+                taskjobs.append(job);
+            }
+        }
+        if (task->batchfiles.toInt() > 0) {
+            QStringList keys;
+            QMap<QString, QList<QSharedPointer<Job>>> groups;
+            for (const QSharedPointer<Job>& job : taskjobs) {
+                if (job->preprocess().copyoriginal.valid() || (!paths.overwrite && QFileInfo::exists(job->output()))
+                    || isUpToDate(job)) {
+                    continue;  // runs on its own, copy original, existing and up to date outputs are handled per job
+                }
+                const QString key = QStringList { job->command(), job->dir(), job->startin(),
+                                                  QString::number(job->arguments().size()) }
+                                        .join('\n');  // compatible jobs only differ in argument values
+                if (!groups.contains(key)) {
+                    keys.append(key);
+                }
+                groups[key].append(job);
+            }
+            for (const QString& key : keys) {
+                const QList<QSharedPointer<Job>> group = groups[key];
+                QList<QSharedPointer<Job>> members;
+                QSet<int> varying;  // argument positions that differ between members
+                qint64 bytes = 0;
+                for (int i = 0; i <= group.size(); ++i) {
+                    qint64 jobbytes = 0;
+                    QSet<int> jobvarying = varying;
+                    if (i < group.size()) {
+                        const QStringList arguments = group[i]->arguments();
+                        for (int j = 0; j < arguments.size(); ++j) {
+                            jobbytes += arguments[j].toLocal8Bit().size() + 1;
+                            if (!members.isEmpty() && arguments[j] != members.first()->arguments().value(j)) {
+                                jobvarying.insert(j);
+                            }
+                        }
+                    }
+                    // a response file lists one argument per file, with more varying the files are split by size
+                    const bool response = !task->batchresponse.isEmpty() && jobvarying.size() == 1;
+                    const bool full = members.size() >= task->batchfiles.toInt()
+                                      || (!response && bytes + jobbytes > task->batchbytes.toInt());
+                    if (!members.isEmpty() && (i == group.size() || full)) {
+                        if (members.size() > 1) {
+                            result.append(updateBatch(task, members));
+                        }
+                        members.clear();
+                        jobvarying.clear();
+                        bytes = 0;
+                    }
+                    if (i < group.size()) {
+                        members.append(group[i]);
+                        varying = jobvarying;
+                        bytes += jobbytes;
+                    }
+                }
+            }
+        }
+        result.append(taskjobs);
+    }
+    return result;
+}
+
+QSharedPointer<Job>
+ProcessorPrivate::updateBatch(const QSharedPointer<Task>& task, const QList<QSharedPointer<Job>>& members)
+{
+    const QSharedPointer<Job> first = members.first();
+    const QStringList arguments = first->arguments();
+    // arguments that differ between members are listed for all members in order, the rest once
+    QStringList values;
+    QStringList batcharguments;
+    QStringList responsearguments;  // used when argv is oversized, the varying argument moves to a file
+    int varyingcount = 0;
+    qint64 bytes = 0;
+    QSharedPointer<Job> job(new Job());
+    const QString filename
+        = QDir(QDir::tempPath()).filePath(QString("jobman-%1.txt").arg(job->uuid().toString(QUuid::Id128)));
+    for (int i = 0; i < arguments.size(); ++i) {
+        bool varying = false;
+        for (const QSharedPointer<Job>& member : members) {
+            varying |= member->arguments().value(i) != arguments[i];
+        }
+        if (varying) {
+            varyingcount++;
+            if (values.isEmpty()) {
+                for (QString argument : task->batchresponse.split(" ")) {
+                    responsearguments.append(argument.replace("%file%", filename));
+                }
+            }
+            for (const QSharedPointer<Job>& member : members) {
+                values.append(member->arguments().value(i));
+                batcharguments.append(member->arguments().value(i));
+                bytes += values.last().toLocal8Bit().size() + 1;
+            }
+        }
+        else {
+            batcharguments.append(arguments[i]);
+            responsearguments.append(arguments[i]);
+            bytes += arguments[i].toLocal8Bit().size() + 1;
+        }
+    }
+    if (bytes > task->batchbytes.toInt() && !task->batchresponse.isEmpty() && varyingcount == 1) {
+        job->response().filename = filename;  // written by the queue for each attempt, removed when finished
+        job->response().lines = values;
+        batcharguments = responsearguments;
+    }
+    QList<QUuid> dependson;
+    for (const QSharedPointer<Job>& member : members) {
+        for (const QUuid& uuid : member->dependson()) {
+            if (!dependson.contains(uuid)) {
+                dependson.append(uuid);
+            }
+        }
+    }
+    {
+        job->setId(QString("%1:batch").arg(first->id()));  // own duration history, runs many files
+        job->setPreset(first->preset());
+        job->setFilename(first->filename());
+        job->setDir(first->dir());
+        job->setName(QString("%1 (%2 files)").arg(first->name()).arg(members.size()));
+        job->setCommand(first->command());
+        job->setArguments(batcharguments);
+        job->setExclusive(first->exclusive());
+        job->setCpuslots(first->cpuslots());
+        job->setMemory(first->memory());
+        job->setGroups(first->groups());
+        job->setOverwrite(first->overwrite());
+        job->setIncremental(first->incremental());
+        job->setIntermediate(first->intermediate());  // admitted against the scratch budget like its members
+        job->setJobserver(first->jobserver());
+        job->setWeight(first->weight());
+        job->setTimeout(first->timeout() * static_cast<int>(members.size()));
+        job->setIdletimeout(first->idletimeout());
+        job->setStartin(first->startin());
+        job->setDependson(dependson);
+        job->setStatus(Job::Waiting);
+    }
+    job->os() = first->os();
+    job->retry() = first->retry();
+    job->worker() = first->worker();
+    for (const QSharedPointer<Job>& member : members) {
+        member->setBatched(true);
+        member->setDependson(QList<QUuid> { job->uuid() });  // parents are waited for by the batched job
+    }
+    return job;
+}
+
+bool
+ProcessorPrivate::isUpToDate(const QSharedPointer<Job>& job)
+{
+    if (!job->incremental() || !job->dependson().isEmpty() || job->output().isEmpty()) {
+        return false;  // outputs of dependent tasks are only known to be current when their parents ran
+    }
+    QFileInfo outputinfo(job->output());
+    QFileInfo inputinfo(job->filename());
+    return outputinfo.exists() && outputinfo.size() > 0 && inputinfo.exists()
+           && inputinfo.lastModified() <= outputinfo.lastModified();
+}
+
 QStringList
 ProcessorPrivate::updateOptions(QList<QSharedPointer<Option>> options, const QString& input)
 {
@@ -288,6 +699,73 @@ ProcessorPrivate::updateOptions(QList<QSharedPointer<Option>> options, const QSt
     return result;
 }
 
+QMap<QString, int>
+ProcessorPrivate::updateGroups(const QSharedPointer<Preset>& preset, const QSharedPointer<Task>& task)
+{
+    QMap<QString, int> groups;
+    for (const QString& group : task->groups) {
+        groups.insert(group, preset->groups().value(group));  // declared, checked when the preset is read
+    }
+    return groups;
+}
+
+Retry
+ProcessorPrivate::updateRetry(const QSharedPointer<Task>& task)
+{
+    Retry retry;
+    retry.attempts = task->attempts.toInt();
+    retry.delay = task->delay.toDouble();
+    retry.maxdelay = task->maxdelay.toDouble();
+    retry.exitcodes = task->exitcodes;
+    retry.signalcodes = task->signalcodes;
+    if (task->patterns.size()) {
+        QStringList patterns;
+        for (const QString& pattern : task->patterns) {
+            patterns.append(QString("(?:%1)").arg(pattern));
+        }
+        retry.patterns = QRegularExpression(patterns.join('|'));  // one pass over stderr for all patterns
+        retry.patterns.optimize();  // compiled here, copies share it
+    }
+    return retry;
+}
+
+QString
+ProcessorPrivate::updateScratch()
+{
+    // one directory per file, inputs with the same name do not collide
+    return QDir(queue->scratchPath()).filePath(QUuid::createUuid().toString(QUuid::Id128));
+}
+
+void
+ProcessorPrivate::updatePipe(const QSharedPointer<Job>& job, const QSharedPointer<Preset>& preset,
+                             const QList<QSharedPointer<Job>>& jobs)
+{
+    for (QSharedPointer<Task> task : preset->tasks()) {
+        if (task->id != job->id() || !task->pipe.toBool()) {
+            continue;
+        }
+        for (const QSharedPointer<Job>& parent : jobs) {
+            if (parent->uuid() == job->dependson().value(0)) {
+                // the parent runs both commands in its slots, its output is the stream between them
+                parent->pipe() = Pipe { job->command(), job->arguments() };
+                parent->setOutput(QString());
+                parent->setCpuslots(qMax(parent->cpuslots(), job->cpuslots()));
+                parent->setMemory(parent->memory() + job->memory());
+                job->setBatched(true);  // completes with the parent once its output is written
+            }
+        }
+    }
+}
+
+Worker
+ProcessorPrivate::updateWorker(const QSharedPointer<Task>& task)
+{
+    Worker worker;
+    worker.jobs = task->workerjobs.toInt();
+    worker.arguments = task->workerarguments.split(" ", Qt::SkipEmptyParts);
+    return worker;
+}
+
 void
 ProcessorPrivate::updateEnvironment(QSharedPointer<Job> job, const Paths& paths)
 {
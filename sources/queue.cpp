@@ -3,18 +3,32 @@
 // https://github.com/mikaelsundell/jobman
 
 #include "queue.h"
+#include "cache.h"
+#include "durations.h"
+#include "jobserver.h"
+#include "journal.h"
 #include "platform.h"
 #include "process.h"
+#include "workers.h"
 
 #include <QCoreApplication>
+#include <QElapsedTimer>
 #include <QFutureWatcher>
 #include <QObject>
 #include <QPointer>
+#include <QPromise>
+#include <QRandomGenerator>
 #include <QSet>
+#include <QSettings>
+#include <QStandardPaths>
 #include <QThreadPool>
+#include <QTimer>
 #include <QtConcurrent>
 
 #include <algorithm>
+#include <cmath>
+#include <memory>
+#include <type_traits>
 
 #define THREAD_FUNC_SAFE() \
     static QMutex mutex;   \
@@ -31,24 +45,80 @@ public:
     QueuePrivate();
     void init();
     void updateThreadCount();
-    QUuid beginBatch(int chunks = 32);
+    void beginBatch(const QUuid& uuid, int chunks = 32);
     void endBatch(const QUuid& uuid);
     QUuid submit(QSharedPointer<Job> job, const QUuid& batch);
     QList<QUuid> submit(const QList<QSharedPointer<Job>>& jobs, const QUuid& batch);
     void start(const QUuid& uuid);
+    void start(const QList<QUuid>& uuids);
     void stop(const QUuid& uuid);
+    void stop(const QList<QUuid>& uuids);
+    void cancel(const QUuid& batch);
+    void setPriority(const QList<QUuid>& uuids, int priority);
     void restart(const QUuid& uuid);
     void restart(const QList<QUuid>& uuids);
     void remove(const QUuid& uuid);
     void remove(const QList<QUuid>& uuids);
-    void processJob(QSharedPointer<Job> job);
+    QList<QUuid> restore();
+    void processJob(QSharedPointer<Job> job, int slot, int jobthreads);
+    bool isUpToDate(const QSharedPointer<Job>& job);
+    QString retryReason(const QSharedPointer<Job>& job, int exitcode, const QString& standarderror, bool started);
+    int retryDelay(const QSharedPointer<Job>& job);
+    void retryJob(const QSharedPointer<Job>& job, int delay);
+    void requeueJob(const QSharedPointer<Job>& job);
+    QStringList jobInputs(const QSharedPointer<Job>& job);
+    void watchJob(const QSharedPointer<Job>& job, Process* process);
+    QString unwatchJob(const QUuid& uuid);
+    void watchJobs();
     QSharedPointer<Job> findNextJob();
+    double pathLength(const QSharedPointer<Job>& job);
+    void updatePaths();
+    double expectedDuration(const QSharedPointer<Job>& job);
+    void updateDuration(const QSharedPointer<Job>& job, qint64 milliseconds);
+    qint64 jobSize(const QSharedPointer<Job>& job);
+    qint64 remainingTime();
+    bool isScratchFull(const QSharedPointer<Job>& job);
+    void holdScratch(const QSharedPointer<Job>& job, const QSet<QUuid>& consumers);
+    void consumeScratch(const QSharedPointer<Job>& job);
+    void removeScratch(const QUuid& uuid);
+    QList<QSharedPointer<Job>> rerunParents(const QSharedPointer<Job>& job);
+    double flowTime(const QUuid& batch) const;
+    void admitJob(const QSharedPointer<Job>& job);
+    bool isSmall(const QUuid& batch) const;
+    QStringList jobGroups(const QSharedPointer<Job>& job);
+    bool isBlocked(const QStringList& groups) const;
+    void acquireGroups(const QStringList& groups);
+    void releaseGroups(const QStringList& groups);
+    void updateGroup(const QString& group);
+    int jobSlots(const QSharedPointer<Job>& job);
+    int jobThreads(const QSharedPointer<Job>& job);
+    int acquireSlot(const QString& preset);
+    void releaseSlot(int slot);
+    QString slotDir(int slot);
+    qint64 jobMemory(const QSharedPointer<Job>& job);
     void processNextJobs();
     void processRemovedJobs();
+    void enqueueJob(const QSharedPointer<Job>& job);
+    void waitJob(const QSharedPointer<Job>& job);
     void processDependentJobs(const QUuid& dependsonUuid);
     void failDependentJobs(const QUuid& dependsonId);
-    void failCompletedJobs(const QUuid& uuid, const QUuid& dependsonId);
+    void failCompletedJobs(const QUuid& uuid, const QList<QUuid>& dependson);
     void killJobs();
+    QList<QSharedPointer<Job>> resolveJobs(const QList<QUuid>& uuids);
+    void updateThreads(int threads);
+    void updateAdaptive(bool adaptive);
+    void updateReserved(int reserved);
+    void updateConcurrency(const std::shared_ptr<const QueueSnapshot>& snapshot);
+    void setConcurrency(int concurrency, const QString& reason);
+    int budget() const;
+    void trackJob(const QSharedPointer<Job>& job);
+    void untrackJob(const QSharedPointer<Job>& job);
+    void updateStatus(const QUuid& uuid, Job::Status status);
+    void updateCounts(const QUuid& batch, const QString& preset, Job::Status status, int delta);
+    void updateWork(const JobState& jobstate, int delta);
+    void publishState();
+    void publishSnapshot();
+    void sample();
     bool isBatch();
     bool isProcessing();
 
@@ -61,26 +131,151 @@ Q_SIGNALS:
 public:
     QString elapsedtime(qint64 milliseconds);
     QString filesize(const QString& filename);
+    template<typename Func> auto invokeAsync(Func func) -> QFuture<decltype(func())>
+    {
+        using Result = decltype(func());
+        auto promise = std::make_shared<QPromise<Result>>();
+        QFuture<Result> future = promise->future();
+        promise->start();
+        QMetaObject::invokeMethod(
+            this,
+            [promise, func]() {
+                if constexpr (std::is_void_v<Result>) {
+                    func();
+                }
+                else {
+                    promise->addResult(func());
+                }
+                promise->finish();
+            },
+            Qt::QueuedConnection);
+        return future;
+    }
+    struct JobState {
+        QUuid batch;
+        QString preset;
+        Job::Status status;
+        qint64 changed;
+        QString id;
+        int cpuslots;
+        double size;  // input megabytes for duration estimates
+    };
+    struct Work {
+        int cpuslots = 0;  // of waiting and running jobs of a task
+        double size = 0.0;  // cpu slots times input megabytes
+    };
+    enum Adaptive { Window = 5, Step = 1 };  // window in samples
+    enum Fairshare { SmallBatch = 16 };      // jobs in a batch that may use reserved slots
+    enum Watchdog { Grace = 10000 };         // msecs between terminate and kill
+    enum Paths { Refresh = 10000 };          // msecs between path updates after the duration model changed
+    struct Watch {
+        Process* process;
+        int pid;
+        qint64 timeout;
+        qint64 idletimeout;
+        qint64 terminated;  // clock msecs when terminate was sent, -1 while running
+        QString reason;
+        bool killed;  // sent once, kill can not be ignored
+    };
+    struct Scratch {
+        QString output;
+        qint64 size = 0;
+        QSet<QUuid> consumers;  // dependents that may still read it
+    };
     int threads;
+    int concurrency;
+    bool adaptive;
+    int direction;
+    int samples;
+    double throughput;
+    quint64 finished;
     int activejobs;
+    int activeslots;
+    int borrowedslots;  // jobserver tokens held by nested tools, count against the budget
+    int jobserverjobs;  // running jobs that may borrow
+    qint64 activememory;
+    qint64 memorybudget;
+    int reserved;
+    QString scratchpath;
+    qint64 scratchbudget;
+    qint64 scratchused;  // completed intermediate outputs not yet consumed
+    qint64 scratchrunning;  // expected outputs of running intermediate jobs, input size as estimate
+    QHash<QUuid, Scratch> scratchoutputs;  // guarded by mutex
+    QList<bool> slotbusy;  // per concurrency slot, grows to the most jobs run at once
+    QList<QString> slotpresets;  // preset last run in each slot
+    double virtualtime;
+    QHash<QUuid, double> flowtimes;  // weighted slot time served per batch, null for standalone jobs
+    QHash<QUuid, qint64> sizes;  // input size per job for duration estimates, guarded by mutex
+    QHash<QUuid, double> paths;  // expected remaining chain per job not yet started, guarded by mutex
+    bool pathsstale;  // the duration model changed since paths were computed
+    qint64 pathsupdated;  // clock msecs at the last update
+    QMutex statemutex;  // guards jobstates and state, never held while taking mutex
+    QHash<QUuid, JobState> jobstates;
+    QHash<QPair<QString, QString>, Work> work;  // remaining work per preset and task, guarded by statemutex
+    int runningslots;  // cpu slots of running jobs
+    qint64 runningsince;  // sum of start times weighted by cpu slots, elapsed work without a scan
+    QElapsedTimer clock;
+    QTimer* sampler;
+    QueueSnapshot state;
+    std::shared_ptr<const QueueSnapshot> snapshot;
     QMutex mutex;
     QThread thread;
     QThreadPool threadpool;
     QMap<QUuid, QSharedPointer<Job>> alljobs;
     QList<QSharedPointer<Job>> waitingjobs;
     QSet<QUuid> completedjobs;
-    QMap<QUuid, QList<QSharedPointer<Job>>> dependentjobs;
+    QMap<QUuid, QList<QSharedPointer<Job>>> dependentjobs;  // listed under every parent not yet completed
+    QHash<QUuid, int> pendingparents;  // parents not yet completed per dependent job
     QMap<QUuid, QSharedPointer<Job>> removedjobs;
-    QMap<QString, QUuid> exclusivejobs;
+    QHash<QString, int> groupjobs;  // running jobs per concurrency group
+    QHash<QString, int> grouplimits;  // one limit per group name, as last declared by a preset
+    QSet<QString> blockedgroups;  // groups at their limit, jobs in them are skipped without a lookup per group
+    QHash<QUuid, QStringList> waitinggroups;  // groups of waiting jobs, resolved once when they start waiting
     QMap<QUuid, QList<QSharedPointer<Job>>> batchjobs;
     QMap<QUuid, int> batchchunks;
+    QHash<QUuid, QSet<QUuid>> batchuuids;
+    QMutex watchmutex;  // guards watches, taken last
+    QHash<QUuid, Watch> watches;  // running jobs with a timeout, checked by the sampler
+    QScopedPointer<Journal> journal;
+    QScopedPointer<Cache> cache;
+    QScopedPointer<Durations> durations;
+    QScopedPointer<Workers> workers;
+    QScopedPointer<Jobserver> jobserver;
     QPointer<Queue> queue;
 };
 
 QueuePrivate::QueuePrivate()
     : threads(1)
+    , concurrency(1)
+    , adaptive(false)
+    , direction(1)
+    , samples(0)
+    , throughput(0.0)
+    , finished(0)
     , activejobs(0)
+    , activeslots(0)
+    , borrowedslots(0)
+    , jobserverjobs(0)
+    , activememory(0)
+    , memorybudget(platform::getPhysicalMemory())
+    , reserved(0)
+    , scratchbudget(0)
+    , scratchused(0)
+    , scratchrunning(0)
+    , virtualtime(0.0)
+    , runningslots(0)
+    , runningsince(0)
+    , pathsstale(false)
+    , pathsupdated(0)
+    , sampler(nullptr)
+    , snapshot(std::make_shared<QueueSnapshot>())
+    , journal(new Journal())
+    , cache(new Cache())
+    , durations(new Durations())
+    , workers(new Workers())
+    , jobserver(new Jobserver())
 {
+    clock.start();
     threadpool.setMaxThreadCount(threads);
     threadpool.setExpiryTimeout(-1);
 }
@@ -94,7 +289,29 @@ QueuePrivate::init()
     // connect
     connect(this, &QueuePrivate::notifyStatusChanged, this, &QueuePrivate::statusChanged, Qt::QueuedConnection);
     updateThreadCount();
+    // scratch, local by default, a ram disk can be set for smaller intermediates
+    QSettings settings(APP_IDENTIFIER, APP_NAME);
+    scratchpath = settings
+                      .value("scratchpath",
+                             QDir(QStandardPaths::writableLocation(QStandardPaths::TempLocation)).filePath("Scratch"))
+                      .toString();
+    scratchbudget = settings.value("scratchsize", 8LL * 1024 * 1024 * 1024).toLongLong();
+    QDir().mkpath(scratchpath);
+    {
+        QMutexLocker locker(&mutex);
+        publishState();  // threads and concurrency are seen before the first scheduling pass
+    }
     thread.start();
+    // sampler
+    QMetaObject::invokeMethod(
+        this,
+        [this]() {
+            sampler = new QTimer(this);  // created on the queue thread, the only caller of getCpuUsage
+            connect(sampler, &QTimer::timeout, this, &QueuePrivate::sample);
+            connect(&thread, &QThread::finished, sampler, &QObject::deleteLater);
+            sampler->start(1000);
+        },
+        Qt::QueuedConnection);
 }
 
 void
@@ -103,13 +320,13 @@ QueuePrivate::updateThreadCount()
     threadpool.setMaxThreadCount(threads);
 }
 
-QUuid
-QueuePrivate::beginBatch(int chunks)
+void
+QueuePrivate::beginBatch(const QUuid& uuid, int chunks)
 {
-    QUuid uuid = QUuid::createUuid();
+    QMutexLocker locker(&mutex);
     batchjobs[uuid] = QList<QSharedPointer<Job>>();
     batchchunks[uuid] = chunks;
-    return uuid;
+    publishState();
 }
 
 void
@@ -119,8 +336,10 @@ QueuePrivate::endBatch(const QUuid& uuid)
         if (!batchjobs[uuid].isEmpty()) {
             queue->batchSubmitted(batchjobs[uuid]);
         }
+        QMutexLocker locker(&mutex);
         batchjobs.remove(uuid);
         batchchunks.remove(uuid);
+        publishState();
     }
 }
 
@@ -162,28 +381,34 @@ QueuePrivate::submit(const QList<QSharedPointer<Job>>& jobs, const QUuid& batch)
                               .arg(job->arguments().join(' '));
             job->setLog(log);
             alljobs.insert(job->uuid(), job);
+            if (!batch.isNull()) {
+                job->setBatch(batch);
+                batchuuids[batch].insert(job->uuid());
+            }
+            journal->submitted(job);
+            trackJob(job);
 
             bool failed = false;
-            if (!job->dependson().isNull() && alljobs.contains(job->dependson())
-                && alljobs[job->dependson()]->status()
-                       == Job::Failed) {  // edge case, dependson job already failed when added
-                job->setStatus(Job::Failed);
-                processeduuids.append(job->uuid());
-                failed = true;
+            for (const QUuid& dependson : job->dependson()) {
+                if (alljobs.contains(dependson) && alljobs[dependson]->status() == Job::Failed) {
+                    // edge case, dependson job already failed when added
+                    job->setStatus(Job::Failed);
+                    processeduuids.append(job->uuid());
+                    failed = true;
+                    break;
+                }
             }
 
             if (!failed) {
-                if (job->dependson().isNull() || completedjobs.contains(job->dependson())) {
-                    waitingjobs.append(job);
-                }
-                else {
-                    dependentjobs[job->dependson()].append(job);
-                }
+                enqueueJob(job);
             }
 
             uuids.append(job->uuid());
             submittedjobs.append(job);
         }
+        for (auto it = submittedjobs.crbegin(); it != submittedjobs.crend(); ++it) {
+            pathLength(*it);  // dependents first, parents reuse their paths
+        }
     }
 
     processNextJobs();
@@ -212,51 +437,144 @@ QueuePrivate::submit(const QList<QSharedPointer<Job>>& jobs, const QUuid& batch)
 
 void
 QueuePrivate::start(const QUuid& uuid)
+{
+    start(QList<QUuid> { uuid });
+}
+
+void
+QueuePrivate::start(const QList<QUuid>& uuids)
 {
     bool start = false;
     {
         QMutexLocker locker(&mutex);
-        QSharedPointer<Job> job = alljobs[uuid];
-        if (job->status() == Job::Stopped) {
-            job->setStatus(Job::Waiting);
-            waitingjobs.append(job);
-            QString log = QString("Uuid:\n"
-                                  "%1\n\n"
-                                  "Command:\n"
-                                  "%2 %3\n")
-                              .arg(job->uuid().toString())
-                              .arg(job->command())
-                              .arg(job->arguments().join(' '));
-            job->setLog(log);
-            start = true;
+        for (const QSharedPointer<Job>& job : resolveJobs(uuids)) {
+            if (job->status() == Job::Stopped) {
+                job->setStatus(Job::Waiting);
+                job->setAttempt(0);
+                for (const QSharedPointer<Job>& parent : rerunParents(job)) {
+                    enqueueJob(parent);
+                }
+                enqueueJob(job);
+                QString log = QString("Uuid:\n"
+                                      "%1\n\n"
+                                      "Command:\n"
+                                      "%2 %3\n")
+                                  .arg(job->uuid().toString())
+                                  .arg(job->command())
+                                  .arg(job->arguments().join(' '));
+                job->setLog(log);
+                start = true;
+            }
         }
     }
     if (start) {
-        processNextJobs();
+        processNextJobs();  // single scheduling pass for all started jobs
     }
 }
 
 void
 QueuePrivate::stop(const QUuid& uuid)
 {
+    stop(QList<QUuid> { uuid });
+}
+
+void
+QueuePrivate::stop(const QList<QUuid>& uuids)
+{
+    {
+        QMutexLocker locker(&mutex);
+        for (const QSharedPointer<Job>& job : resolveJobs(uuids)) {
+            if (job->status() == Job::Running) {
+                job->setStatus(Job::Stopped);
+                int pid = job->pid();
+                if (pid > 0) {
+                    Process::kill(pid);
+                }
+                QString log = QString("Uuid:\n"
+                                      "%1\n\n"
+                                      "Command:\n"
+                                      "%2 %3\n")
+                                  .arg(job->uuid().toString())
+                                  .arg(job->command())
+                                  .arg(job->arguments().join(' '));
+                job->setLog(log);
+            }
+        }
+    }
+    processNextJobs();
+}
+
+void
+QueuePrivate::cancel(const QUuid& batch)
+{
+    QList<QUuid> processeduuids;
     {
         QMutexLocker locker(&mutex);
-        QSharedPointer<Job> job = alljobs[uuid];
-        if (job->status() == Job::Running) {
+        QSet<QUuid> cancelleduuids;
+        for (const QSharedPointer<Job>& job : resolveJobs(QList<QUuid> { batch })) {
+            const Job::Status status = job->status();
+            if (status != Job::Waiting && status != Job::Running) {
+                continue;
+            }
             job->setStatus(Job::Stopped);
-            int pid = job->pid();
-            if (pid > 0) {
-                Process::kill(job->pid());
+            if (status == Job::Running) {
+                int pid = job->pid();
+                if (pid > 0) {
+                    Process::kill(pid);
+                }
+            }
+            else {
+                cancelleduuids.insert(job->uuid());
+                processeduuids.append(job->uuid());
+                consumeScratch(job);
             }
             QString log = QString("Uuid:\n"
                                   "%1\n\n"
                                   "Command:\n"
-                                  "%2 %3\n")
+                                  "%2 %3\n\n"
+                                  "Status:\n"
+                                  "Command cancelled, batch was cancelled: %4\n")
                               .arg(job->uuid().toString())
                               .arg(job->command())
-                              .arg(job->arguments().join(' '));
+                              .arg(job->arguments().join(' '))
+                              .arg(batch.toString());
             job->setLog(log);
         }
+        if (!cancelleduuids.isEmpty()) {
+            auto cancelled = [&](const QSharedPointer<Job>& job) { return cancelleduuids.contains(job->uuid()); };
+            waitingjobs.erase(std::remove_if(waitingjobs.begin(), waitingjobs.end(), cancelled), waitingjobs.end());
+            for (const QUuid& uuid : cancelleduuids) {
+                pendingparents.remove(uuid);
+                waitinggroups.remove(uuid);
+                paths.remove(uuid);
+            }
+            for (auto it = dependentjobs.begin(); it != dependentjobs.end();) {
+                QList<QSharedPointer<Job>>& jobs = it.value();
+                jobs.erase(std::remove_if(jobs.begin(), jobs.end(), cancelled), jobs.end());
+                if (jobs.isEmpty()) {
+                    it = dependentjobs.erase(it);
+                }
+                else {
+                    ++it;
+                }
+            }
+        }
+    }
+    if (!processeduuids.isEmpty()) {
+        queue->jobsProcessed(processeduuids);
+    }
+    processNextJobs();
+}
+
+void
+QueuePrivate::setPriority(const QList<QUuid>& uuids, int priority)
+{
+    {
+        QMutexLocker locker(&mutex);
+        for (const QSharedPointer<Job>& job : resolveJobs(uuids)) {
+            job->setPriority(priority);
+            journal->priorityChanged(job->uuid(), priority);
+        }
     }
     processNextJobs();
 }
@@ -277,14 +595,12 @@ QueuePrivate::restart(const QList<QUuid>& uuids)
                 QSharedPointer<Job> job = alljobs[jobUuid];
                 if (job->status() != Job::Running) {
                     job->setStatus(Job::Waiting);
-                    if (job->dependson().isNull()) {
-                        waitingjobs.append(job);
-                    }
-                    else {
-                        if (!dependentjobs[job->dependson()].contains(job)) {
-                            dependentjobs[job->dependson()].append(job);
-                        }
+                    job->setAttempt(0);
+                    completedjobs.remove(jobUuid);  // dependents restarted below wait for it again
+                    for (const QSharedPointer<Job>& parent : rerunParents(job)) {
+                        enqueueJob(parent);
                     }
+                    enqueueJob(job);
                     QString log = QString("Uuid:\n"
                                           "%1\n\n"
                                           "Command:\n"
@@ -300,7 +616,7 @@ QueuePrivate::restart(const QList<QUuid>& uuids)
                     }
                     job->setLog(log);
                     for (QSharedPointer<Job>& dependentJob : alljobs) {
-                        if (dependentJob->dependson() == jobUuid) {
+                        if (dependentJob->dependson().contains(jobUuid)) {
                             restartJob(dependentJob->uuid());
                         }
                     }
@@ -337,7 +653,7 @@ QueuePrivate::remove(const QList<QUuid>& uuids)
             processeduuids.append(uuid);
             for (auto it = alljobs.cbegin(); it != alljobs.cend(); ++it) {
                 const QSharedPointer<Job>& job = it.value();
-                if (job && job->dependson() == uuid) {
+                if (job && job->dependson().contains(uuid)) {
                     pendinguuids.append(job->uuid());
                 }
             }
@@ -350,6 +666,10 @@ QueuePrivate::remove(const QList<QUuid>& uuids)
                 continue;
             }
             removedjobs.insert(uuid, job);
+            if (job->status() != Job::Completed) {
+                consumeScratch(job);
+            }
+            removeScratch(uuid);
             if (job->status() == Job::Running) {
                 const int pid = job->pid();
                 if (pid > 0) {
@@ -357,12 +677,20 @@ QueuePrivate::remove(const QList<QUuid>& uuids)
                 }
             }
             dependentjobs.remove(uuid);
+            pendingparents.remove(uuid);
             waitingjobs.removeAll(job);
+            waitinggroups.remove(uuid);
+            paths.remove(uuid);
             completedjobs.remove(uuid);
-            if (job->exclusive()) {
-                const QString command = job->command();
-                if (exclusivejobs.value(command) == uuid) {
-                    exclusivejobs.remove(command);
+            untrackJob(job);
+            sizes.remove(uuid);
+            journal->removed(uuid);
+            const QUuid batch = job->batch();
+            if (!batch.isNull() && batchuuids.contains(batch)) {
+                QSet<QUuid>& members = batchuuids[batch];
+                members.remove(uuid);
+                if (members.isEmpty()) {
+                    batchuuids.remove(batch);
                 }
             }
         }
@@ -399,6 +727,7 @@ QueuePrivate::remove(const QList<QUuid>& uuids)
                 }
             }
         }
+        publishState();
     }
 
     if (!processeduuids.isEmpty()) {
@@ -408,12 +737,110 @@ QueuePrivate::remove(const QList<QUuid>& uuids)
     }
 }
 
+QList<QUuid>
+QueuePrivate::restore()
+{
+    const QList<QSharedPointer<Job>> jobs = journal->restore();
+    QList<QUuid> uuids;
+    {
+        QMutexLocker locker(&mutex);
+        QList<QSharedPointer<Job>> restoredjobs;
+        for (const QSharedPointer<Job>& job : jobs) {
+            if (alljobs.contains(job->uuid())) {
+                continue;
+            }
+            QString log = QString("Uuid:\n"
+                                  "%1\n\n"
+                                  "Created:\n"
+                                  "%2\n\n"
+                                  "Command:\n"
+                                  "%3 %4\n\n"
+                                  "Restored:\n"
+                                  "%5\n")
+                              .arg(job->uuid().toString())
+                              .arg(job->created().toString("yyyy-MM-dd HH:mm:ss"))
+                              .arg(job->command())
+                              .arg(job->arguments().join(' '))
+                              .arg(QDateTime::currentDateTime().toString("yyyy-MM-dd HH:mm:ss"));
+            job->setLog(log);
+            alljobs.insert(job->uuid(), job);
+            if (!job->batch().isNull()) {
+                batchuuids[job->batch()].insert(job->uuid());
+            }
+            if (job->status() == Job::Completed) {
+                completedjobs.insert(job->uuid());
+            }
+            trackJob(job);
+            restoredjobs.append(job);
+        }
+        QHash<QUuid, QSet<QUuid>> consumers;
+        for (const QSharedPointer<Job>& job : restoredjobs) {
+            if (job->status() != Job::Waiting) {
+                continue;
+            }
+            rerunParents(job);  // reset to waiting, enqueued below
+            for (const QUuid& dependson : job->dependson()) {
+                consumers[dependson].insert(job->uuid());
+            }
+        }
+        for (const QSharedPointer<Job>& job : restoredjobs) {
+            if (job->status() != Job::Waiting) {
+                continue;
+            }
+            enqueueJob(job);
+            uuids.append(job->uuid());
+        }
+        for (const QSharedPointer<Job>& job : restoredjobs) {
+            if (job->intermediate() && job->status() == Job::Completed) {
+                holdScratch(job, consumers.value(job->uuid()));  // kept on disk when the queue was killed
+            }
+        }
+        for (auto it = restoredjobs.crbegin(); it != restoredjobs.crend(); ++it) {
+            pathLength(*it);
+        }
+    }
+    processNextJobs();
+    if (!jobs.isEmpty()) {
+        queue->jobsSubmitted(jobs);
+    }
+    return uuids;
+}
+
 void
-QueuePrivate::processJob(QSharedPointer<Job> job)
+QueuePrivate::processJob(QSharedPointer<Job> job, int slot, int jobthreads)
 {
-    QString log = job->log();
+    bool retrying = false;
+    QString log;  // appended to the job log, never rewritten while running
     QFileInfo commandInfo(job->command());
-    if (commandInfo.isAbsolute() && !commandInfo.exists()) {
+    job->setSkipped(false);
+    if (job->incremental() && isUpToDate(job)) {
+        log += QString("\nStatus:\n"
+                       "Command skipped, output is up to date: %1\n")
+                   .arg(job->output());
+        {
+            QMutexLocker locker(&statemutex);
+            state.skipped++;
+        }
+        job->setSkipped(true);
+        job->setStatus(Job::Completed);  // dependents run as if the job had completed
+    }
+    else if (job->batched()) {
+        // the command ran in the batched or piped job this job depends on, only the output is left to check
+        const QString output = job->output();
+        if (output.isEmpty() || QFileInfo(output).isFile()) {
+            log += QString("\nStatus:\n"
+                           "Command completed in batched or piped job: %1\n")
+                       .arg(job->dependson().value(0).toString());
+            job->setStatus(Job::Completed);
+        }
+        else {
+            log += QString("\nStatus:\n"
+                           "Output file missing after batched or piped job: %1\n")
+                       .arg(output);
+            job->setStatus(Job::Failed);
+        }
+    }
+    else if (commandInfo.isAbsolute() && !commandInfo.exists()) {
         log += QString("\nCommand error:\nCommand path could not be found: %1\n").arg(job->command());
         job->setStatus(Job::Failed);
     }
@@ -428,7 +855,52 @@ QueuePrivate::processJob(QSharedPointer<Job> job)
                 }
             }
         }
+        Pipe pipe = job->pipe();
+        if (pipe.valid() && !QFileInfo(pipe.command).isAbsolute()) {
+            for (QString searchpath : job->os().searchpaths) {
+                QString filepath = QDir::cleanPath(QDir(searchpath).filePath(pipe.command));
+                if (QFile::exists(filepath)) {
+                    pipe.command = filepath;
+                    break;
+                }
+            }
+        }
+        // slot and threads, expanded at spawn since both are only known once the job is admitted
+        const QString slotdir = slotDir(slot);
+        auto updateSlot = [&](QString value) {
+            return value.replace("%slotdir%", slotdir)
+                .replace("%slot%", QString::number(slot))
+                .replace("%threads%", QString::number(jobthreads));
+        };
+        QStringList arguments;
+        for (const QString& argument : job->arguments()) {
+            arguments.append(updateSlot(argument));
+        }
+        for (QString& argument : pipe.arguments) {
+            argument = updateSlot(argument);
+        }
+        QList<QPair<QString, QString>> environmentvars = job->os().environmentvars;
+        for (QPair<QString, QString>& environmentvar : environmentvars) {
+            environmentvar.second = updateSlot(environmentvar.second);
+        }
+        for (const QString& name : { QString("OMP_NUM_THREADS"), QString("TBB_NUM_THREADS") }) {
+            auto named = [&](const QPair<QString, QString>& environmentvar) { return environmentvar.first == name; };
+            if (std::none_of(environmentvars.begin(), environmentvars.end(), named)) {
+                environmentvars.append(qMakePair(name, QString::number(jobthreads)));  // presets may set their own
+            }
+        }
+        if (job->jobserver() && jobserver->isValid()) {
+            auto named = [&](const QPair<QString, QString>& environmentvar) {
+                return environmentvar.first == "MAKEFLAGS";
+            };
+            if (std::none_of(environmentvars.begin(), environmentvars.end(), named)) {
+                const int jobs = std::atomic_load(&snapshot)->concurrency;
+                environmentvars.append(qMakePair(QString("MAKEFLAGS"), jobserver->makeflags(jobs)));
+            }
+        }
+        const QString startin = updateSlot(job->startin());
         job->setStatus(Job::Running);
+        job->setAttempt(job->attempt() + 1);
         bool valid = false;
         // test output
         QString output = job->output();
@@ -449,6 +921,9 @@ QueuePrivate::processJob(QSharedPointer<Job> job)
                 valid = true;
             }
         }
+        else {
+            valid = true;  // no output to test, e.g. a batched job writing member outputs
+        }
         // test dir
         if (valid) {
             QString dirname = job->dir();
@@ -513,18 +988,54 @@ QueuePrivate::processJob(QSharedPointer<Job> job)
                     }
                 }
             }
-            if (!failed) {
+            // cache
+            QString cachekey;
+            bool cached = false;
+            if (!failed && job->cache() && output.size()) {
+                cachekey = cache->key(job, command, jobInputs(job));
+                if (cachekey.size() && cache->restore(cachekey, output)) {
+                    log += QString("\nStatus:\n"
+                                   "Command skipped, output restored from cache: %1\n")
+                               .arg(cachekey);
+                    job->setStatus(Job::Completed);
+                    cached = true;
+                }
+            }
+            if (!failed && !cached) {
                 // process
-                QScopedPointer<Process> process(new Process());
+                QSharedPointer<Process> process(new Process());
                 QString standardoutput;
                 QString standarderror;
-                if (process->exists(command)) {
+                QString retryreason;
+                QString timedout;
+                int exitcode = -1;
+                const Response response = job->response();
+                bool written = true;
+                if (response.valid()) {
+                    QFile file(response.filename);  // one argument per line, restarts write it again
+                    written = file.open(QIODevice::WriteOnly | QIODevice::Text)
+                              && file.write((response.lines.join('\n') + '\n').toLocal8Bit()) >= 0;
+                }
+                if (!written) {
+                    standarderror = QString("Response file could not be written: %1\n").arg(response.filename);
+                    failed = true;
+                }
+                else if (process->exists(command) && (!pipe.valid() || process->exists(pipe.command))) {
                     QElapsedTimer elapsed;
                     elapsed.start();
-                    process->run(command, job->arguments(), job->startin(), job->os().environmentvars);
+                    const Worker worker = job->worker();
+                    if (worker.valid()) {
+                        // the job keeps its slot while the worker runs it
+                        process = workers->acquire(command, job, startin, environmentvars);
+                    }
+                    else {
+                        if (pipe.valid()) {
+                            process->setPipe(pipe.command, pipe.arguments);
+                        }
+                        process->run(command, arguments, startin, environmentvars);
+                    }
                     int pid = process->pid();
                     job->setPid(pid);
-                    QList<QPair<QString, QString>> environmentvars = job->os().environmentvars;
                     if (environmentvars.count()) {
                         log += QString("\nEnvironment:\n");
                         for (const QPair<QString, QString>& environmentvar : environmentvars) {
@@ -539,9 +1050,38 @@ QueuePrivate::processJob(QSharedPointer<Job> job)
                         }
                     }
                     log += QString("\nProcess id:\n%1\n").arg(pid);
+                    log += QString("\nSlot:\n%1\n").arg(slot);
+                    log += QString("\nThreads:\n%1\n").arg(jobthreads);
+                    if (pipe.valid()) {
+                        log += QString("\nPipe:\n%1 %2\n").arg(pipe.command).arg(pipe.arguments.join(' '));
+                    }
+                    if (worker.valid()) {
+                        log += QString("\nWorker:\nProcess id %1, job %2 of %3 before it is replaced\n")
+                                   .arg(pid)
+                                   .arg(workers->served(process) + 1)
+                                   .arg(worker.jobs);
+                    }
                     log += QString("\nStarted:\n%1\n").arg(QDateTime::currentDateTime().toString("yyyy-MM-dd HH:mm:ss"));
-                    job->setLog(log);
-                    if (process->wait()) {
+                    job->appendLog(log);
+                    log.clear();
+                    watchJob(job, process.data());
+                    const bool completed = worker.valid()
+                                               ? workers->request(process, job, arguments, startin, standardoutput,
+                                                                  standarderror, exitcode)
+                                               : process->wait();
+                    timedout = unwatchJob(job->uuid());
+                    if (worker.valid()) {
+                        workers->release(process, job);
+                    }
+                    else {
+                        standardoutput = process->standardOutput();
+                        standarderror = process->standardError();
+                        exitcode = process->exitCode();
+                    }
+                    if (completed && timedout.isEmpty()) {
+                        if (cachekey.size()) {
+                            cache->insert(cachekey, output);  // before dependents can touch the output
+                        }
                         job->setStatus(Job::Completed);
                         log += QString("\nStatus:\n%1\n").arg("Command completed");
                     }
@@ -553,28 +1093,43 @@ QueuePrivate::processJob(QSharedPointer<Job> job)
                             failed = true;
                         }
                     }
-                    standardoutput = process->standardOutput();
-                    standarderror = process->standardError();
                     qint64 milliseconds = elapsed.elapsed();
+                    if (job->status() == Job::Completed) {
+                        updateDuration(job, milliseconds);
+                    }
                     log += QString("\nElapsed time:\n%1\n").arg(elapsedtime(milliseconds));
+                    if (failed && timedout.isEmpty()) {  // timed out jobs fail, a hang is not retried
+                        retryreason = retryReason(job, exitcode, standarderror, !process->failedToStart());
+                    }
                 }
                 else {
                     standarderror = "Command does not exists, make sure command can be "
                                     "found in system or application search paths";
                     failed = true;
                 }
+                if (response.valid()) {
+                    QFile::remove(response.filename);
+                }
                 if (failed) {
-                    log += QString("\nStatus:\n%1\n").arg("Command failed");
-                    log += QString("\nExit code:\n%1\n").arg(process->exitCode());
-                    switch (process->exitStatus()) {
-                    case Process::Normal: {
-                        log += QString("\nExit status:\n%1\n").arg("Normal");
-                    } break;
-                    case Process::Crash: {
-                        log += QString("\nExit status:\n%1\n").arg("Crash");
-                    } break;
+                    log += QString("\nStatus:\n%1\n")
+                               .arg(timedout.size() ? QString("Command timed out, %1").arg(timedout)
+                                                    : QString("Command failed"));
+                    log += QString("\nExit code:\n%1\n").arg(exitcode);
+                    log += QString("\nExit status:\n%1\n").arg(exitcode == 0 ? "Normal" : "Crash");
+                    if (retryreason.size()) {
+                        const int delay = retryDelay(job);
+                        log += QString("\nRetry:\nAttempt %1 of %2 failed, %3, retrying in %4 ms\n")
+                                   .arg(job->attempt())
+                                   .arg(job->retry().attempts)
+                                   .arg(retryreason)
+                                   .arg(delay);
+                        job->setStatus(Job::Waiting);
+                        retryJob(job, delay);
+                        retrying = true;
+                    }
+                    else {
+                        job->setStatus(Job::Failed);
                     }
-                    job->setStatus(Job::Failed);
                 }
                 if (stopped) {
                     log += QString("\nStatus:\n%1\n").arg("Command stopped");
@@ -588,107 +1143,661 @@ QueuePrivate::processJob(QSharedPointer<Job> job)
             }
         }
     }
-    job->setLog(log);
-    queue->jobsProcessed(QList<QUuid> { job->uuid() });
+    job->appendLog(log);
+    if (!retrying) {
+        queue->jobsProcessed(QList<QUuid> { job->uuid() });
+    }
 }
 
-QSharedPointer<Job>
-QueuePrivate::findNextJob()
+QString
+QueuePrivate::retryReason(const QSharedPointer<Job>& job, int exitcode, const QString& standarderror, bool started)
 {
-    int index = -1;
-    QSharedPointer<Job> nextjob;
-    for (int i = 0; i < waitingjobs.size(); ++i) {
-        QSharedPointer<Job> job = waitingjobs[i];
-        if (job->exclusive() && exclusivejobs.contains(job->command()))
-            continue;
-
-        if (!nextjob) {
-            nextjob = job;
-            index = i;
-        }
-        else if (job->priority() > nextjob->priority()) {
-            nextjob = job;
-            index = i;
-        }
-        else if (job->priority() == nextjob->priority() && job->created() < nextjob->created()) {
-            nextjob = job;
-            index = i;
-        }
+    const Retry retry = job->retry();
+    if (!retry.valid() || job->attempt() >= retry.attempts) {
+        return QString();
     }
-    if (index != -1) {
-        if (nextjob->exclusive()) {
-            exclusivejobs[nextjob->command()] = nextjob->uuid();
-        }
-
-        return waitingjobs.takeAt(index);
+    if (!started) {
+        return "process failed to start";  // spawn errors like EAGAIN are always transient
     }
-    return QSharedPointer<Job>();
-}
-
-void
-QueuePrivate::processNextJobs()
-{
-    QMutexLocker locker(&mutex);
-
-    const int free = qMax(0, threadpool.maxThreadCount() - activejobs);
-    const int jobsprocess = qMin(waitingjobs.size(), free);
-    if (jobsprocess <= 0) {
-        return;
+    const bool patterns = !retry.patterns.pattern().isEmpty();
+    if (retry.exitcodes.isEmpty() && retry.signalcodes.isEmpty() && !patterns) {
+        return QString("exit code %1").arg(exitcode);  // no matchers, any failure is retried
     }
-
-    QList<QSharedPointer<Job>> jobsrun;
-    jobsrun.reserve(jobsprocess);
-
-    for (int i = 0; i < jobsprocess; ++i) {
-        if (waitingjobs.isEmpty()) {
-            break;
-        }
-
-        const QSharedPointer<Job> job = findNextJob();
-        if (!job) {
-            break;
+    if (exitcode > 0 && retry.exitcodes.contains(exitcode)) {
+        return QString("exit code %1").arg(exitcode);
+    }
+    if (exitcode < 0 && retry.signalcodes.contains(-exitcode)) {
+        return QString("signal %1").arg(-exitcode);
+    }
+    if (patterns) {
+        QRegularExpressionMatch match = retry.patterns.match(standarderror);
+        if (match.hasMatch()) {
+            return QString("error matched: %1").arg(match.captured(0));
         }
-
-        jobsrun.append(job);
     }
+    return QString();
+}
 
-    for (const QSharedPointer<Job>& job : jobsrun) {
-        ++activejobs;
-
-        QFuture<void> future = QtConcurrent::run(&threadpool, [this, job]() { processJob(job); });
-
-        QFutureWatcher<void>* watcher = new QFutureWatcher<void>(this);
-        connect(
-            watcher, &QFutureWatcher<void>::finished, this,
-            [this, watcher, job]() {
-                watcher->deleteLater();
-
-                {
-                    QMutexLocker locker(&mutex);
-                    activejobs = qMax(0, activejobs - 1);
-                }
-
-                statusChanged(job->uuid(), job->status());
-            },
-            Qt::QueuedConnection);
-        watcher->setFuture(future);
-    }
+int
+QueuePrivate::retryDelay(const QSharedPointer<Job>& job)
+{
+    const Retry retry = job->retry();
+    const double backoff = qMin(retry.maxdelay, retry.delay * std::pow(2.0, qMax(0, job->attempt() - 1)));
+    const double jitter = 0.5 + QRandomGenerator::global()->bounded(0.5);  // spreads retries of a failed batch
+    return static_cast<int>(backoff * jitter * 1000.0);
 }
 
 void
-QueuePrivate::processRemovedJobs()
+QueuePrivate::retryJob(const QSharedPointer<Job>& job, int delay)
 {
-    removedjobs.clear();  // safe to clear at submit, all event are processed
+    QMetaObject::invokeMethod(
+        this,
+        [this, job, delay]() {
+            QTimer::singleShot(delay, this, [this, job]() { requeueJob(job); });  // no worker sleeps during backoff
+        },
+        Qt::QueuedConnection);
 }
 
 void
-QueuePrivate::processDependentJobs(const QUuid& dependsonId)
+QueuePrivate::requeueJob(const QSharedPointer<Job>& job)
 {
-    if (dependentjobs.contains(dependsonId)) {
-        for (QSharedPointer<Job> job : dependentjobs[dependsonId]) {
-            waitingjobs.append(job);
+    {
+        QMutexLocker locker(&mutex);
+        if (!alljobs.contains(job->uuid()) || job->status() != Job::Waiting || waitingjobs.contains(job)) {
+            return;  // removed, cancelled or restarted during backoff
+        }
+        waitJob(job);
+    }
+    processNextJobs();
+}
+
+bool
+QueuePrivate::isUpToDate(const QSharedPointer<Job>& job)
+{
+    const QString output = job->output();
+    if (output.isEmpty()) {
+        return false;
+    }
+    QFileInfo outputinfo(output);
+    if (!outputinfo.exists() || outputinfo.size() == 0) {
+        return false;  // missing or truncated by an interrupted run
+    }
+    for (const QString& input : jobInputs(job)) {
+        QFileInfo inputinfo(input);  // parent output is newer when the parent ran again
+        if (!inputinfo.exists() || inputinfo.size() == 0 || inputinfo.lastModified() > outputinfo.lastModified()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+QStringList
+QueuePrivate::jobInputs(const QSharedPointer<Job>& job)
+{
+    QStringList inputs;
+    if (!job->filename().isEmpty()) {
+        inputs.append(job->filename());
+    }
+    const QList<QUuid> dependson = job->dependson();
+    if (!dependson.isEmpty()) {
+        QMutexLocker locker(&mutex);
+        for (const QUuid& uuid : dependson) {
+            if (alljobs.contains(uuid) && !alljobs[uuid]->output().isEmpty()) {
+                inputs.append(alljobs[uuid]->output());
+            }
+        }
+    }
+    return inputs;
+}
+
+void
+QueuePrivate::watchJob(const QSharedPointer<Job>& job, Process* process)
+{
+    const int timeout = job->timeout();
+    const int idletimeout = job->idletimeout();
+    if ((timeout <= 0 && idletimeout <= 0) || process->pid() <= 0) {
+        return;  // no timeout or the process failed to start, never signal pid -1
+    }
+    QMutexLocker locker(&watchmutex);
+    watches.insert(job->uuid(),
+                   Watch { process, process->pid(), timeout * 1000LL, idletimeout * 1000LL, -1, QString(), false });
+}
+
+QString
+QueuePrivate::unwatchJob(const QUuid& uuid)
+{
+    QMutexLocker locker(&watchmutex);
+    return watches.take(uuid).reason;  // empty unless the watchdog ended the process
+}
+
+void
+QueuePrivate::watchJobs()
+{
+    // one pass per sample on the queue thread instead of a timer per job
+    QMutexLocker locker(&watchmutex);
+    const qint64 now = clock.elapsed();
+    for (auto it = watches.begin(); it != watches.end(); ++it) {
+        Watch& watch = it.value();
+        if (watch.terminated < 0) {
+            if (watch.timeout > 0 && watch.process->elapsed() > watch.timeout) {
+                watch.reason = QString("no exit after %1").arg(elapsedtime(watch.timeout));
+            }
+            else if (watch.idletimeout > 0 && watch.process->idle() > watch.idletimeout) {
+                watch.reason = QString("no output for %1").arg(elapsedtime(watch.idletimeout));
+            }
+            else {
+                continue;
+            }
+            Process::terminate(watch.pid);
+            watch.terminated = now;
+        }
+        else if (!watch.killed && now - watch.terminated > Grace) {
+            Process::kill(watch.pid);  // ignored terminate, the piped command is killed with it
+            watch.killed = true;
+        }
+    }
+}
+
+QSharedPointer<Job>
+QueuePrivate::findNextJob()
+{
+    int index = -1;
+    QSharedPointer<Job> nextjob;
+    double nexttime = 0.0;
+    const int limit = qMax(1, budget() - reserved);  // slots large batches may fill
+    double nextpath = 0.0;
+    bool nextchained = false;
+    QHash<QUuid, double> times;
+    QHash<QUuid, bool> small;
+    for (int i = 0; i < waitingjobs.size(); ++i) {
+        QSharedPointer<Job> job = waitingjobs[i];
+        if (!blockedgroups.isEmpty() && isBlocked(waitinggroups.value(job->uuid())))
+            continue;
+
+        if (job->intermediate() && job->dependson().isEmpty() && isScratchFull(job))
+            continue;  // new files wait for scratch, files in progress free it
+
+        const QUuid batch = job->batch();
+        if (!small.contains(batch)) {
+            small.insert(batch, isSmall(batch));
+            times.insert(batch, flowTime(batch));
+        }
+        if (!small.value(batch) && activeslots + borrowedslots + jobSlots(job) > limit) {
+            continue;  // remaining slots are reserved for small batches
+        }
+        const double time = times.value(batch);
+        const bool chained = !job->dependson().isEmpty();  // parents completed, the file is in progress
+        const double path = pathLength(job);
+        bool next;
+        if (!nextjob) {
+            next = true;
+        }
+        else if (job->priority() != nextjob->priority()) {
+            next = job->priority() > nextjob->priority();
+        }
+        else if (time != nexttime) {
+            next = time < nexttime;  // least served batch first, weighted by preset
+        }
+        else if (chained != nextchained) {
+            next = chained;  // finish started files first, intermediates do not pile up
+        }
+        else if (path != nextpath) {
+            next = path > nextpath;  // longest remaining path first, shortens the makespan
+        }
+        else {
+            next = job->created() < nextjob->created();
+        }
+        if (next) {
+            nextjob = job;
+            nexttime = time;
+            nextchained = chained;
+            nextpath = path;
+            index = i;
+        }
+    }
+    if (index != -1) {
+        const qint64 memory = jobMemory(nextjob);
+        if (activeslots + borrowedslots + jobSlots(nextjob) > budget()
+            || (memory > 0 && activememory + memory > memorybudget)) {
+            return QSharedPointer<Job>();  // highest priority job waits for resources, no lower priority bypass
+        }
+        acquireGroups(waitinggroups.value(nextjob->uuid()));
+        admitJob(nextjob);
+        return waitingjobs.takeAt(index);
+    }
+    return QSharedPointer<Job>();
+}
+
+double
+QueuePrivate::pathLength(const QSharedPointer<Job>& job)
+{
+    const QUuid uuid = job->uuid();  // called with mutex held, computed once and kept until the job starts
+    auto it = paths.constFind(uuid);
+    if (it != paths.constEnd()) {
+        return it.value();
+    }
+    double downstream = 0.0;
+    for (const QSharedPointer<Job>& dependent : dependentjobs.value(uuid)) {
+        downstream = qMax(downstream, pathLength(dependent));
+    }
+    const double path = expectedDuration(job) + downstream;
+    paths.insert(uuid, path);
+    return path;
+}
+
+void
+QueuePrivate::updatePaths()
+{
+    paths.clear();  // called with mutex held, only jobs not yet started are ranked
+    for (const QSharedPointer<Job>& job : waitingjobs) {
+        pathLength(job);  // pending dependents are reached through their waiting ancestors
+    }
+    pathsstale = false;
+    pathsupdated = clock.elapsed();
+}
+
+double
+QueuePrivate::expectedDuration(const QSharedPointer<Job>& job)
+{
+    const double expected = durations->expected(job->preset(), job->id(), jobSize(job));
+    return expected >= 0.0 ? expected : 1000.0;  // unseen tasks count as one second
+}
+
+void
+QueuePrivate::updateDuration(const QSharedPointer<Job>& job, qint64 milliseconds)
+{
+    qint64 size;
+    {
+        QMutexLocker locker(&mutex);
+        size = jobSize(job);
+    }
+    durations->update(job->preset(), job->id(), size, milliseconds);
+    QMutexLocker locker(&mutex);
+    pathsstale = true;  // updated by the sampler, not on every completion
+}
+
+qint64
+QueuePrivate::jobSize(const QSharedPointer<Job>& job)
+{
+    const QUuid uuid = job->uuid();  // called with mutex held
+    auto it = sizes.constFind(uuid);
+    if (it != sizes.constEnd()) {
+        return it.value();
+    }
+    // the dropped file is known for every task in the chain, intermediates may not exist yet
+    const qint64 size = job->filename().isEmpty() ? 0 : QFileInfo(job->filename()).size();
+    sizes.insert(uuid, size);
+    return size;
+}
+
+qint64
+QueuePrivate::remainingTime()
+{
+    QMutexLocker locker(&statemutex);  // per task, not per job, the queue mutex is not taken
+    double remaining = 0.0;  // expected slot msecs of waiting and running jobs
+    for (auto it = work.constBegin(); it != work.constEnd(); ++it) {
+        double intercept = 1000.0;  // unseen tasks count as one second
+        double slope = 0.0;
+        durations->coefficients(it.key().first, it.key().second, intercept, slope);
+        remaining += intercept * it->cpuslots + slope * it->size;
+    }
+    remaining -= static_cast<double>(runningslots) * clock.elapsed() - runningsince;
+    return static_cast<qint64>(qMax(0.0, remaining) / qMax(1, budget()));
+}
+
+bool
+QueuePrivate::isScratchFull(const QSharedPointer<Job>& job)
+{
+    if (scratchbudget <= 0) {
+        return false;
+    }
+    const qint64 used = scratchused + scratchrunning;
+    return used > 0 && used + jobSize(job) > scratchbudget;  // a single file larger than the budget still runs
+}
+
+void
+QueuePrivate::holdScratch(const QSharedPointer<Job>& job, const QSet<QUuid>& consumers)
+{
+    scratchused = qMax<qint64>(0, scratchused - scratchoutputs.take(job->uuid()).size);  // restarted, counted again
+    if (consumers.isEmpty()) {
+        return;  // nothing reads it back, kept like any other output
+    }
+    const qint64 size = QFileInfo(job->output()).size();
+    scratchoutputs.insert(job->uuid(), Scratch { job->output(), size, consumers });
+    scratchused += size;
+}
+
+void
+QueuePrivate::consumeScratch(const QSharedPointer<Job>& job)
+{
+    for (const QUuid& parent : job->dependson()) {
+        auto it = scratchoutputs.find(parent);  // once per dependent, whichever way it ended
+        if (it != scratchoutputs.end() && it->consumers.remove(job->uuid()) && it->consumers.isEmpty()) {
+            removeScratch(parent);
+        }
+    }
+}
+
+void
+QueuePrivate::removeScratch(const QUuid& uuid)
+{
+    const Scratch scratch = scratchoutputs.take(uuid);
+    if (scratch.output.isEmpty()) {
+        return;
+    }
+    QFile::remove(scratch.output);
+    QDir().rmdir(QFileInfo(scratch.output).path());  // the file directory, once all its intermediates are gone
+    scratchused = qMax<qint64>(0, scratchused - scratch.size);
+}
+
+QList<QSharedPointer<Job>>
+QueuePrivate::rerunParents(const QSharedPointer<Job>& job)
+{
+    QList<QSharedPointer<Job>> parents;  // called with mutex held, reset to waiting, enqueued by the caller
+    for (const QUuid& uuid : job->dependson()) {
+        auto it = scratchoutputs.find(uuid);
+        if (it != scratchoutputs.end()) {
+            it->consumers.insert(job->uuid());  // still on disk, read again by the restarted job
+            continue;
+        }
+        const QSharedPointer<Job> parent = alljobs.value(uuid);
+        if (!parent || !parent->intermediate() || !completedjobs.contains(uuid) || parent->output().isEmpty()
+            || QFileInfo::exists(parent->output())) {
+            continue;  // completed, or marked dependency failed by this job, with its output removed
+        }
+        parents.append(rerunParents(parent));  // its own intermediate inputs may be gone too
+        parent->setStatus(Job::Waiting);
+        parent->setAttempt(0);
+        completedjobs.remove(uuid);  // the job waits for it again
+        parent->appendLog(QString("\nStatus:\n"
+                                  "Command restarted, intermediate output was removed before job: %1\n")
+                              .arg(job->uuid().toString()));
+        parents.append(parent);
+    }
+    return parents;
+}
+
+double
+QueuePrivate::flowTime(const QUuid& batch) const
+{
+    return qMax(virtualtime, flowtimes.value(batch, virtualtime));  // idle batches restart at the current time
+}
+
+void
+QueuePrivate::admitJob(const QSharedPointer<Job>& job)
+{
+    const QUuid batch = job->batch();
+    virtualtime = flowTime(batch);
+    flowtimes[batch] = virtualtime + static_cast<double>(jobSlots(job)) / qMax(1, job->weight());
+    if (flowtimes.size() > 1024) {
+        for (auto it = flowtimes.begin(); it != flowtimes.end();) {
+            it = (it.value() <= virtualtime) ? flowtimes.erase(it) : ++it;  // same as unseen batches
+        }
+    }
+}
+
+bool
+QueuePrivate::isSmall(const QUuid& batch) const
+{
+    return batch.isNull() || batchuuids.value(batch).size() <= SmallBatch;
+}
+
+QStringList
+QueuePrivate::jobGroups(const QSharedPointer<Job>& job)
+{
+    QMap<QString, int> groups = job->groups();  // called with mutex held, limits are declared as jobs start waiting
+    if (job->exclusive()) {
+        groups.insert(QString("exclusive:%1").arg(job->command()), 1);  // exclusive is a group of one per command
+    }
+    for (auto it = groups.constBegin(); it != groups.constEnd(); ++it) {
+        if (grouplimits.value(it.key()) != it.value()) {
+            grouplimits.insert(it.key(), it.value());
+            updateGroup(it.key());
+        }
+    }
+    return groups.keys();
+}
+
+bool
+QueuePrivate::isBlocked(const QStringList& groups) const
+{
+    for (const QString& group : groups) {
+        if (blockedgroups.contains(group)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void
+QueuePrivate::acquireGroups(const QStringList& groups)
+{
+    for (const QString& group : groups) {
+        groupjobs[group]++;
+        updateGroup(group);
+    }
+}
+
+void
+QueuePrivate::releaseGroups(const QStringList& groups)
+{
+    for (const QString& group : groups) {
+        auto it = groupjobs.find(group);
+        if (it != groupjobs.end() && --it.value() <= 0) {
+            groupjobs.erase(it);
+        }
+        updateGroup(group);
+    }
+}
+
+void
+QueuePrivate::updateGroup(const QString& group)
+{
+    if (groupjobs.value(group, 0) >= grouplimits.value(group, 1)) {
+        blockedgroups.insert(group);
+    }
+    else {
+        blockedgroups.remove(group);
+    }
+}
+
+int
+QueuePrivate::jobSlots(const QSharedPointer<Job>& job)
+{
+    return qBound(1, job->cpuslots(), qMax(1, budget()));  // larger requests run alone
+}
+
+int
+QueuePrivate::jobThreads(const QSharedPointer<Job>& job)
+{
+    // cores shared by the slots in use, a queue with jobs waiting is full and shares them by budget
+    const int occupied = waitingjobs.isEmpty() ? activeslots : qMax(activeslots, budget());
+    return qMax(1, QThread::idealThreadCount() * jobSlots(job) / qMax(1, occupied));
+}
+
+int
+QueuePrivate::acquireSlot(const QString& preset)
+{
+    int slot = -1;
+    for (int i = 0; i < slotbusy.size(); ++i) {
+        if (slotbusy[i]) {
+            continue;
+        }
+        if (slotpresets[i] == preset) {
+            slot = i;  // warm for this preset
+            break;
+        }
+        if (slot < 0 || (!slotpresets[slot].isEmpty() && slotpresets[i].isEmpty())) {
+            slot = i;  // unused before another preset's, keeps its caches warm
+        }
+    }
+    if (slot < 0) {
+        slot = slotbusy.size();
+        slotbusy.append(false);
+        slotpresets.append(QString());
+    }
+    slotbusy[slot] = true;
+    slotpresets[slot] = preset;
+    return slot;
+}
+
+void
+QueuePrivate::releaseSlot(int slot)
+{
+    if (slot >= 0 && slot < slotbusy.size()) {
+        slotbusy[slot] = false;
+    }
+}
+
+QString
+QueuePrivate::slotDir(int slot)
+{
+    const QString path = QDir(QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation))
+                             .filePath(QString("Slots/%1").arg(slot));
+    QDir().mkpath(path);  // kept between jobs and launches, tool caches stay warm
+    return path;
+}
+
+qint64
+QueuePrivate::jobMemory(const QSharedPointer<Job>& job)
+{
+    if (memorybudget <= 0) {
+        return 0;  // unknown physical memory, not enforced
+    }
+    return qBound<qint64>(0, job->memory(), memorybudget);
+}
+
+void
+QueuePrivate::processNextJobs()
+{
+    QMutexLocker locker(&mutex);
+
+    // tokens not taken by nested tools come back, the queue admits before lending again
+    if (jobserverjobs > 0) {
+        borrowedslots = jobserver->reclaim();
+    }
+    else {
+        borrowedslots = 0;
+        jobserver->clear();  // tokens left by tools that exited holding them
+    }
+
+    QList<QSharedPointer<Job>> jobsrun;
+    while (!waitingjobs.isEmpty() && activejobs + jobsrun.size() < threadpool.maxThreadCount()) {
+        const QSharedPointer<Job> job = findNextJob();  // admitted against slot and memory budgets
+        if (!job) {
+            break;
+        }
+        activeslots += jobSlots(job);
+        activememory += jobMemory(job);
+        scratchrunning += job->intermediate() ? jobSize(job) : 0;
+        jobserverjobs += job->jobserver() ? 1 : 0;
+        paths.remove(job->uuid());
+        jobsrun.append(job);
+    }
+    if (jobserverjobs > 0) {
+        jobserver->lend(qMax(0, budget() - activeslots - borrowedslots));  // free slots while nothing else fits
+    }
+
+    for (const QSharedPointer<Job>& job : jobsrun) {
+        ++activejobs;
+        const int cpuslots = jobSlots(job);
+        const qint64 memory = jobMemory(job);
+        const qint64 scratch = job->intermediate() ? jobSize(job) : 0;
+        const QStringList groups = waitinggroups.take(job->uuid());  // acquired when admitted
+        const int slot = acquireSlot(job->preset());
+        const int jobthreads = jobThreads(job);
+
+        QFuture<void> future = QtConcurrent::run(
+            &threadpool, [this, job, slot, jobthreads]() { processJob(job, slot, jobthreads); });
+
+        QFutureWatcher<void>* watcher = new QFutureWatcher<void>(this);
+        connect(
+            watcher, &QFutureWatcher<void>::finished, this,
+            [this, watcher, job, cpuslots, memory, scratch, groups, slot]() {
+                watcher->deleteLater();
+
+                {
+                    QMutexLocker locker(&mutex);
+                    activejobs = qMax(0, activejobs - 1);
+                    activeslots = qMax(0, activeslots - cpuslots);
+                    activememory = qMax<qint64>(0, activememory - memory);
+                    scratchrunning = qMax<qint64>(0, scratchrunning - scratch);
+                    jobserverjobs = qMax(0, jobserverjobs - (job->jobserver() ? 1 : 0));
+                    releaseSlot(slot);
+                    releaseGroups(groups);  // released once per admitted job, also when stopped or removed
+                    publishState();
+                }
+
+                statusChanged(job->uuid(), job->status());
+            },
+            Qt::QueuedConnection);
+        watcher->setFuture(future);
+    }
+    publishState();
+}
+
+void
+QueuePrivate::processRemovedJobs()
+{
+    removedjobs.clear();  // safe to clear at submit, all event are processed
+}
+
+void
+QueuePrivate::enqueueJob(const QSharedPointer<Job>& job)
+{
+    int pending = 0;  // called with mutex held
+    for (const QUuid& dependson : job->dependson()) {
+        if (!completedjobs.contains(dependson) && alljobs.contains(dependson)) {
+            QList<QSharedPointer<Job>>& jobs = dependentjobs[dependson];
+            if (!jobs.contains(job)) {
+                jobs.append(job);
+                QList<QUuid> ancestors { dependson };  // their chains grew
+                QSet<QUuid> visited;
+                while (!ancestors.isEmpty()) {
+                    const QUuid ancestor = ancestors.takeLast();
+                    if (visited.contains(ancestor) || !alljobs.contains(ancestor)) {
+                        continue;
+                    }
+                    visited.insert(ancestor);
+                    paths.remove(ancestor);
+                    ancestors.append(alljobs[ancestor]->dependson());
+                }
+            }
+            pending++;
+        }
+    }
+    if (pending > 0) {
+        pendingparents.insert(job->uuid(), pending);
+    }
+    else {
+        pendingparents.remove(job->uuid());
+        waitJob(job);
+    }
+}
+
+void
+QueuePrivate::waitJob(const QSharedPointer<Job>& job)
+{
+    const QStringList groups = jobGroups(job);  // called with mutex held
+    if (!groups.isEmpty()) {
+        waitinggroups.insert(job->uuid(), groups);
+    }
+    waitingjobs.append(job);
+}
+
+void
+QueuePrivate::processDependentJobs(const QUuid& dependsonId)
+{
+    const QList<QSharedPointer<Job>> jobs = dependentjobs.take(dependsonId);
+    for (const QSharedPointer<Job>& job : jobs) {
+        auto it = pendingparents.find(job->uuid());
+        if (it == pendingparents.end()) {
+            continue;  // failed through another parent
+        }
+        if (--it.value() == 0) {
+            pendingparents.erase(it);  // last parent completed, joins once
+            waitJob(job);
         }
-        dependentjobs.remove(dependsonId);
     }
 }
 
@@ -707,8 +1816,8 @@ QueuePrivate::failDependentJobs(const QUuid& dependsonId)
         visiteduuids.insert(currentuuid);
         const QList<QSharedPointer<Job>> jobs = dependentjobs.take(currentuuid);
         for (const QSharedPointer<Job>& job : jobs) {
-            if (!job || visiteduuids.contains(job->uuid())) {
-                continue;
+            if (!job || visiteduuids.contains(job->uuid()) || !pendingparents.remove(job->uuid())) {
+                continue;  // already failed through another parent
             }
             QString log = QString("Uuid:\n"
                                   "%1\n\n"
@@ -739,15 +1848,16 @@ QueuePrivate::failDependentJobs(const QUuid& dependsonId)
 }
 
 void
-QueuePrivate::failCompletedJobs(const QUuid& uuid, const QUuid& dependsonId)
+QueuePrivate::failCompletedJobs(const QUuid& uuid, const QList<QUuid>& dependson)
 {
-    if (alljobs.contains(dependsonId)) {
-        QSharedPointer<Job> job = alljobs[dependsonId];
-        QString log = job->log();
-        log += QString("\nDependent error:\n%1").arg("Dependent job failed: %1").arg(uuid.toString());
-        job->setLog(log);
-        job->setStatus(Job::DependencyFailed);
-        if (!job->dependson().isNull()) {
+    for (const QUuid& dependsonId : dependson) {
+        if (alljobs.contains(dependsonId)) {
+            QSharedPointer<Job> job = alljobs[dependsonId];
+            if (job->status() == Job::DependencyFailed) {
+                continue;  // shared ancestor, already marked through another parent
+            }
+            job->appendLog(QString("\nDependent error:\nDependent job failed: %1").arg(uuid.toString()));
+            job->setStatus(Job::DependencyFailed);
             failCompletedJobs(dependsonId, job->dependson());
         }
     }
@@ -756,6 +1866,8 @@ QueuePrivate::failCompletedJobs(const QUuid& uuid, const QUuid& dependsonId)
 void
 QueuePrivate::killJobs()
 {
+    journal->close();  // running jobs stay running in the journal and are requeued on restore
+    workers->clear();
     {
         QMutexLocker locker(&mutex);
         for (QSharedPointer<Job>& job : alljobs) {
@@ -771,13 +1883,39 @@ QueuePrivate::killJobs()
         QMutexLocker locker(&mutex);
         waitingjobs.clear();
         dependentjobs.clear();
+        pendingparents.clear();
         alljobs.clear();
         completedjobs.clear();
         removedjobs.clear();
-        exclusivejobs.clear();
+        groupjobs.clear();
+        grouplimits.clear();
+        blockedgroups.clear();
+        waitinggroups.clear();
+        paths.clear();
+        sizes.clear();
         activejobs = 0;
+        activeslots = 0;
+        borrowedslots = 0;
+        jobserverjobs = 0;
+        jobserver->clear();
+        activememory = 0;
+        scratchused = 0;
+        scratchrunning = 0;
+        scratchoutputs.clear();  // kept on disk, rebuilt from restored jobs
         batchjobs.clear();
         batchchunks.clear();
+        batchuuids.clear();
+        {
+            QMutexLocker statelocker(&statemutex);
+            jobstates.clear();
+            work.clear();
+            runningslots = 0;
+            runningsince = 0;
+            state.jobs = QueueCounts();
+            state.batches.clear();
+            state.presets.clear();
+        }
+        publishState();
     }
     threadpool.clear();
     threadpool.waitForDone();
@@ -785,29 +1923,287 @@ QueuePrivate::killJobs()
     thread.wait();
 }
 
-bool
-QueuePrivate::isBatch()
+QList<QSharedPointer<Job>>
+QueuePrivate::resolveJobs(const QList<QUuid>& uuids)
 {
-    QMutexLocker locker(&mutex);
-    return !batchjobs.isEmpty();
+    QList<QSharedPointer<Job>> jobs;
+    QSet<QUuid> resolveduuids;
+    auto resolve = [&](const QUuid& uuid) {
+        if (!resolveduuids.contains(uuid) && alljobs.contains(uuid)) {
+            resolveduuids.insert(uuid);
+            jobs.append(alljobs.value(uuid));
+        }
+    };
+    for (const QUuid& uuid : uuids) {
+        if (batchuuids.contains(uuid)) {  // batch uuids expand to all of their jobs
+            for (const QUuid& jobuuid : batchuuids.value(uuid)) {
+                resolve(jobuuid);
+            }
+        }
+        else {
+            resolve(uuid);
+        }
+    }
+    return jobs;
 }
 
-bool
-QueuePrivate::isProcessing()
+void
+QueuePrivate::updateThreads(int threads)
 {
-    QMutexLocker locker(&mutex);
-    if (activejobs > 0) {
-        return true;
+    if (this->threads == threads) {
+        return;
     }
-    if (!waitingjobs.isEmpty()) {
-        return true;
+    this->threads = threads;
+    updateThreadCount();
+    if (!adaptive) {
+        concurrency = threads;
     }
-    for (const QSharedPointer<Job> job : alljobs) {
-        if (job->status() == Job::Running) {
-            return true;
+    else if (concurrency > threads) {
+        setConcurrency(threads, "max threads lowered");
+    }
+    processNextJobs();
+}
+
+void
+QueuePrivate::updateAdaptive(bool adaptive)
+{
+    if (this->adaptive == adaptive) {
+        return;
+    }
+    this->adaptive = adaptive;
+    direction = 1;
+    samples = 0;
+    throughput = 0.0;
+    finished = std::atomic_load(&snapshot)->finished;
+    if (adaptive) {
+        setConcurrency(qMax(1, threads / 2), "adaptive enabled, probing from half of max threads");
+    }
+    else {
+        setConcurrency(threads, "adaptive disabled");
+    }
+    processNextJobs();
+}
+
+void
+QueuePrivate::updateReserved(int reserved)
+{
+    {
+        QMutexLocker locker(&mutex);
+        this->reserved = qMax(0, reserved);
+        publishState();
+    }
+    processNextJobs();
+}
+
+void
+QueuePrivate::updateConcurrency(const std::shared_ptr<const QueueSnapshot>& snapshot)
+{
+    if (!adaptive || ++samples < Window) {
+        return;
+    }
+    const double current = (snapshot->finished - finished) / static_cast<double>(samples);
+    const bool saturated = snapshot->waiting > 0;  // demand exceeds the current budget
+    finished = snapshot->finished;
+    samples = 0;
+    if (!saturated) {
+        throughput = current;
+        return;
+    }
+    // hill-climbing on completed jobs per second, multiplicative decrease on cpu saturation
+    if (snapshot->cpu > 95.0 && concurrency > 1) {
+        direction = -1;
+        setConcurrency(qMax(1, concurrency * 3 / 4),
+                       QString("cpu at %1%, backing off").arg(snapshot->cpu, 0, 'f', 0));
+    }
+    else if (current > throughput * 1.05) {
+        setConcurrency(concurrency + direction * Step,
+                       QString("throughput improved to %1 jobs/sec").arg(current, 0, 'f', 2));
+    }
+    else if (current < throughput * 0.95) {
+        direction = -direction;
+        setConcurrency(concurrency + direction * Step,
+                       QString("throughput dropped to %1 jobs/sec, reversing").arg(current, 0, 'f', 2));
+    }
+    throughput = current;
+}
+
+void
+QueuePrivate::setConcurrency(int concurrency, const QString& reason)
+{
+    concurrency = qBound(1, concurrency, qMax(1, threads));
+    if (this->concurrency == concurrency) {
+        if (concurrency == 1 || concurrency == threads) {
+            direction = (concurrency == 1) ? 1 : -1;  // probe back from the bounds
         }
+        return;
     }
-    return false;
+    this->concurrency = concurrency;
+    queue->concurrencyChanged(concurrency, reason);
+}
+
+int
+QueuePrivate::budget() const
+{
+    return adaptive ? concurrency : threads;
+}
+
+void
+QueuePrivate::trackJob(const QSharedPointer<Job>& job)
+{
+    const QUuid uuid = job->uuid();
+    connect(
+        job.data(), &Job::statusChanged, this, [this, uuid](Job::Status status) { updateStatus(uuid, status); },
+        Qt::DirectConnection);  // runs on the thread changing the status, job mutex is held
+    JobState jobstate { job->batch(), job->preset(), job->status(), clock.elapsed(),
+                        job->id(), jobSlots(job), static_cast<double>(jobSize(job)) / (1024.0 * 1024.0) };
+    QMutexLocker locker(&statemutex);  // counts are published with the next scheduling pass or sample
+    jobstates.insert(uuid, jobstate);
+    updateCounts(jobstate.batch, jobstate.preset, jobstate.status, 1);
+    updateWork(jobstate, 1);
+}
+
+void
+QueuePrivate::untrackJob(const QSharedPointer<Job>& job)
+{
+    const QUuid uuid = job->uuid();
+    job->disconnect(this);
+    QMutexLocker locker(&statemutex);
+    if (jobstates.contains(uuid)) {
+        JobState jobstate = jobstates.take(uuid);
+        updateCounts(jobstate.batch, jobstate.preset, jobstate.status, -1);
+        updateWork(jobstate, -1);
+    }
+}
+
+void
+QueuePrivate::updateStatus(const QUuid& uuid, Job::Status status)
+{
+    journal->statusChanged(uuid, status);
+    QMutexLocker locker(&statemutex);
+    auto it = jobstates.find(uuid);
+    if (it != jobstates.end() && it->status != status) {
+        const qint64 changed = clock.elapsed();
+        if (it->status == Job::Waiting && status == Job::Running) {
+            state.started++;
+            state.waittime += changed - it->changed;
+        }
+        else if (it->status == Job::Running) {
+            state.finished++;
+            state.runtime += changed - it->changed;
+        }
+        updateCounts(it->batch, it->preset, it->status, -1);
+        updateWork(*it, -1);
+        it->status = status;
+        it->changed = changed;
+        updateCounts(it->batch, it->preset, it->status, 1);
+        updateWork(*it, 1);
+    }
+}
+
+void
+QueuePrivate::updateCounts(const QUuid& batch, const QString& preset, Job::Status status, int delta)
+{
+    state.jobs.statuses[status] += delta;  // called with statemutex held
+    if (!batch.isNull()) {
+        QueueCounts& counts = state.batches[batch];
+        counts.statuses[status] += delta;
+        if (!counts.total()) {
+            state.batches.remove(batch);
+        }
+    }
+    if (!preset.isEmpty()) {
+        QueueCounts& counts = state.presets[preset];
+        counts.statuses[status] += delta;
+        if (!counts.total()) {
+            state.presets.remove(preset);
+        }
+    }
+}
+
+void
+QueuePrivate::updateWork(const JobState& jobstate, int delta)
+{
+    if (jobstate.status != Job::Waiting && jobstate.status != Job::Running) {
+        return;  // called with statemutex held
+    }
+    const QPair<QString, QString> key(jobstate.preset, jobstate.id);
+    Work& task = work[key];
+    task.cpuslots += delta * jobstate.cpuslots;
+    task.size += delta * jobstate.cpuslots * jobstate.size;
+    if (task.cpuslots <= 0) {
+        work.remove(key);
+    }
+    if (jobstate.status == Job::Running) {
+        runningslots += delta * jobstate.cpuslots;
+        runningsince += delta * jobstate.cpuslots * jobstate.changed;  // changed is the start while running
+    }
+}
+
+void
+QueuePrivate::publishState()
+{
+    QMutexLocker locker(&statemutex);  // called with mutex held
+    state.threads = threads;
+    state.concurrency = budget();
+    state.adaptive = adaptive;
+    state.reserved = reserved;
+    state.active = activejobs;
+    state.activeslots = activeslots + borrowedslots;
+    state.activememory = activememory;
+    state.memorybudget = memorybudget;
+    state.waiting = static_cast<int>(waitingjobs.size());
+    state.batch = !batchjobs.isEmpty();
+    state.processing = activejobs > 0 || !waitingjobs.isEmpty();
+    state.cachehits = cache->hits();
+    state.cachemisses = cache->misses();
+    publishSnapshot();
+}
+
+void
+QueuePrivate::publishSnapshot()
+{
+    state.epoch++;  // called with statemutex held, readers keep the snapshot they loaded
+    std::atomic_store(&snapshot, std::shared_ptr<const QueueSnapshot>(std::make_shared<QueueSnapshot>(state)));
+}
+
+void
+QueuePrivate::sample()
+{
+    const double cpu = platform::getCpuUsage();
+    const qint64 remaining = remainingTime();
+    {
+        QMutexLocker locker(&statemutex);
+        state.cpu = cpu;
+        state.remaining = remaining;
+        publishSnapshot();
+    }
+    const int previous = concurrency;
+    updateConcurrency(std::atomic_load(&snapshot));
+    if (concurrency != previous || jobserverjobs > 0) {
+        processNextJobs();  // tokens returned by nested tools are only seen when reclaimed
+    }
+    {
+        QMutexLocker locker(&mutex);
+        if (pathsstale && clock.elapsed() - pathsupdated > Refresh) {
+            updatePaths();
+        }
+    }
+    watchJobs();
+    workers->expire(60000);  // idle workers hold memory between batches
+    journal->flush();  // records batched into one fsync per sample
+    durations->flush();
+}
+
+bool
+QueuePrivate::isBatch()
+{
+    return std::atomic_load(&snapshot)->batch;
+}
+
+bool
+QueuePrivate::isProcessing()
+{
+    return std::atomic_load(&snapshot)->processing;
 }
 
 void
@@ -822,27 +2218,26 @@ QueuePrivate::statusChanged(const QUuid& uuid, Job::Status status)
                 return;
             }
 
-            if (status == Job::Completed || status == Job::Failed || status == Job::DependencyFailed
-                || status == Job::Stopped) {
-                if (job->exclusive()) {
-                    const QString command = job->command();
-                    if (exclusivejobs.contains(command)) {
-                        Q_ASSERT(exclusivejobs.value(command) == job->uuid());
-                        exclusivejobs.remove(command);
-                    }
-                }
-            }
-
             if (status == Job::Completed) {
                 completedjobs.insert(uuid);
+                if (job->intermediate()) {
+                    QSet<QUuid> consumers;  // before dependents are released from the parent
+                    for (const QSharedPointer<Job>& dependent : dependentjobs.value(uuid)) {
+                        consumers.insert(dependent->uuid());
+                    }
+                    holdScratch(job, consumers);
+                }
+                consumeScratch(job);
                 processDependentJobs(uuid);
             }
             else if (status == Job::Failed) {
-                if (!job->dependson().isNull()) {
-                    failCompletedJobs(job->uuid(), job->dependson());
-                }
+                consumeScratch(job);  // a restart runs removed parents again
+                failCompletedJobs(job->uuid(), job->dependson());
                 failDependentJobs(uuid);
             }
+            else if (status == Job::DependencyFailed || status == Job::Stopped) {
+                consumeScratch(job);
+            }
         }
     }
 
@@ -918,14 +2313,15 @@ Queue::instance()
 QUuid
 Queue::beginBatch(int chunks)
 {
+    QUuid uuid = QUuid::createUuid();
     if (QThread::currentThread() == &p->thread) {
-        return p->beginBatch(chunks);
+        p->beginBatch(uuid, chunks);
+        return uuid;
     }
 
-    QUuid result;
     QMetaObject::invokeMethod(
-        p.data(), [this, chunks, &result]() { result = p->beginBatch(chunks); }, Qt::BlockingQueuedConnection);
-    return result;
+        p.data(), [this, uuid, chunks]() { p->beginBatch(uuid, chunks); }, Qt::BlockingQueuedConnection);
+    return uuid;
 }
 
 void
@@ -987,6 +2383,51 @@ Queue::stop(const QUuid& uuid)
     QMetaObject::invokeMethod(p.data(), [this, uuid]() { p->stop(uuid); }, Qt::BlockingQueuedConnection);
 }
 
+void
+Queue::start(const QList<QUuid>& uuids)
+{
+    if (QThread::currentThread() == &p->thread) {
+        p->start(uuids);
+        return;
+    }
+
+    QMetaObject::invokeMethod(p.data(), [this, uuids]() { p->start(uuids); }, Qt::BlockingQueuedConnection);
+}
+
+void
+Queue::stop(const QList<QUuid>& uuids)
+{
+    if (QThread::currentThread() == &p->thread) {
+        p->stop(uuids);
+        return;
+    }
+
+    QMetaObject::invokeMethod(p.data(), [this, uuids]() { p->stop(uuids); }, Qt::BlockingQueuedConnection);
+}
+
+void
+Queue::cancel(const QUuid& batch)
+{
+    if (QThread::currentThread() == &p->thread) {
+        p->cancel(batch);
+        return;
+    }
+
+    QMetaObject::invokeMethod(p.data(), [this, batch]() { p->cancel(batch); }, Qt::BlockingQueuedConnection);
+}
+
+void
+Queue::setPriority(const QList<QUuid>& uuids, int priority)
+{
+    if (QThread::currentThread() == &p->thread) {
+        p->setPriority(uuids, priority);
+        return;
+    }
+
+    QMetaObject::invokeMethod(
+        p.data(), [this, uuids, priority]() { p->setPriority(uuids, priority); }, Qt::BlockingQueuedConnection);
+}
+
 void
 Queue::restart(const QUuid& uuid)
 {
@@ -1031,66 +2472,180 @@ Queue::remove(const QList<QUuid>& uuids)
     QMetaObject::invokeMethod(p.data(), [this, uuids]() { p->remove(uuids); }, Qt::BlockingQueuedConnection);
 }
 
-int
-Queue::threads() const
+QList<QUuid>
+Queue::restore()
 {
     if (QThread::currentThread() == &p->thread) {
-        return p->threads;
+        return p->restore();
     }
 
-    int result = 0;
-    QMetaObject::invokeMethod(p.data(), [this, &result]() { result = p->threads; }, Qt::BlockingQueuedConnection);
+    QList<QUuid> result;
+    QMetaObject::invokeMethod(p.data(), [this, &result]() { result = p->restore(); }, Qt::BlockingQueuedConnection);
     return result;
 }
 
+int
+Queue::threads() const
+{
+    return std::atomic_load(&p->snapshot)->threads;
+}
+
 void
 Queue::setThreads(int threads)
 {
     if (QThread::currentThread() == &p->thread) {
-        if (p->threads == threads) {
-            return;
-        }
+        p->updateThreads(threads);
+        return;
+    }
+
+    QMetaObject::invokeMethod(p.data(), [this, threads]() { p->updateThreads(threads); }, Qt::BlockingQueuedConnection);
+}
+
+bool
+Queue::isAdaptive() const
+{
+    return std::atomic_load(&p->snapshot)->adaptive;
+}
 
-        p->threads = threads;
-        p->updateThreadCount();
-        p->processNextJobs();
+void
+Queue::setAdaptive(bool adaptive)
+{
+    if (QThread::currentThread() == &p->thread) {
+        p->updateAdaptive(adaptive);
         return;
     }
 
-    QMetaObject::invokeMethod(
-        p.data(),
-        [this, threads]() {
-            if (p->threads == threads) {
-                return;
-            }
+    QMetaObject::invokeMethod(p.data(), [this, adaptive]() { p->updateAdaptive(adaptive); }, Qt::BlockingQueuedConnection);
+}
 
-            p->threads = threads;
-            p->updateThreadCount();
-            p->processNextJobs();
-        },
-        Qt::BlockingQueuedConnection);
+int
+Queue::reserved() const
+{
+    return std::atomic_load(&p->snapshot)->reserved;
 }
 
-bool
-Queue::isBatch()
+void
+Queue::setReserved(int reserved)
 {
     if (QThread::currentThread() == &p->thread) {
-        return p->isBatch();
+        p->updateReserved(reserved);
+        return;
     }
 
-    bool result = false;
-    QMetaObject::invokeMethod(p.data(), [this, &result]() { result = p->isBatch(); }, Qt::BlockingQueuedConnection);
-    return result;
+    QMetaObject::invokeMethod(
+        p.data(), [this, reserved]() { p->updateReserved(reserved); }, Qt::BlockingQueuedConnection);
+}
+
+bool
+Queue::isBatch()
+{
+    return p->isBatch();
 }
 
 bool
 Queue::isProcessing()
 {
-    if (QThread::currentThread() == &p->thread) {
-        return p->isProcessing();
-    }
+    return p->isProcessing();
+}
 
-    bool result = false;
-    QMetaObject::invokeMethod(p.data(), [this, &result]() { result = p->isProcessing(); }, Qt::BlockingQueuedConnection);
-    return result;
+std::shared_ptr<const QueueSnapshot>
+Queue::snapshot() const
+{
+    return std::atomic_load(&p->snapshot);
+}
+
+double
+Queue::expectedDuration(const QString& preset, const QString& id, qint64 size) const
+{
+    return p->durations->expected(preset, id, size);  // thread safe, the model has its own lock
+}
+
+QString
+Queue::scratchPath() const
+{
+    return p->scratchpath;  // set once at init
+}
+
+double
+Queue::durationPercentile(const QString& preset, const QString& id, double percentile) const
+{
+    return p->durations->percentile(preset, id, percentile);
+}
+
+QFuture<void>
+Queue::beginBatchAsync(const QUuid& uuid, int chunks)
+{
+    return p->invokeAsync([this, uuid, chunks]() { p->beginBatch(uuid, chunks); });
+}
+
+QFuture<void>
+Queue::endBatchAsync(const QUuid& uuid)
+{
+    return p->invokeAsync([this, uuid]() { p->endBatch(uuid); });
+}
+
+QFuture<QList<QUuid>>
+Queue::submitAsync(const QList<QSharedPointer<Job>>& jobs, const QUuid& batch)
+{
+    return p->invokeAsync([this, jobs, batch]() { return p->submit(jobs, batch); });
+}
+
+QFuture<void>
+Queue::startAsync(const QList<QUuid>& uuids)
+{
+    return p->invokeAsync([this, uuids]() { p->start(uuids); });
+}
+
+QFuture<void>
+Queue::stopAsync(const QList<QUuid>& uuids)
+{
+    return p->invokeAsync([this, uuids]() { p->stop(uuids); });
+}
+
+QFuture<void>
+Queue::cancelAsync(const QUuid& batch)
+{
+    return p->invokeAsync([this, batch]() { p->cancel(batch); });
+}
+
+QFuture<void>
+Queue::setPriorityAsync(const QList<QUuid>& uuids, int priority)
+{
+    return p->invokeAsync([this, uuids, priority]() { p->setPriority(uuids, priority); });
+}
+
+QFuture<void>
+Queue::restartAsync(const QList<QUuid>& uuids)
+{
+    return p->invokeAsync([this, uuids]() { p->restart(uuids); });
+}
+
+QFuture<void>
+Queue::removeAsync(const QList<QUuid>& uuids)
+{
+    return p->invokeAsync([this, uuids]() { p->remove(uuids); });
+}
+
+QFuture<QList<QUuid>>
+Queue::restoreAsync()
+{
+    return p->invokeAsync([this]() { return p->restore(); });
+}
+
+QFuture<void>
+Queue::setThreadsAsync(int threads)
+{
+    return p->invokeAsync([this, threads]() { p->updateThreads(threads); });
+}
+
+QFuture<void>
+Queue::setAdaptiveAsync(bool adaptive)
+{
+    return p->invokeAsync([this, adaptive]() { p->updateAdaptive(adaptive); });
+}
+
+QFuture<void>
+Queue::setReservedAsync(int reserved)
+{
+    return p->invokeAsync([this, reserved]() { p->updateReserved(reserved); });
 }
@@ -6,9 +6,56 @@
 
 #include "job.h"
 
+#include <QFuture>
+#include <QHash>
 #include <QObject>
 #include <QScopedPointer>
 
+#include <array>
+#include <memory>
+
+struct QueueCounts {
+public:
+    int count(Job::Status status) const { return statuses[status]; }
+    int total() const
+    {
+        int total = 0;
+        for (int count : statuses) {
+            total += count;
+        }
+        return total;
+    }
+    std::array<int, Job::Stopped + 1> statuses {};
+};
+
+struct QueueSnapshot {
+public:
+    quint64 epoch = 0;  // increases with every publish
+    int threads = 0;
+    int concurrency = 0;  // cpu slot budget, below threads when adaptive
+    bool adaptive = false;
+    int reserved = 0;  // cpu slots kept for small batches
+    int active = 0;
+    int activeslots = 0;
+    qint64 activememory = 0;  // in bytes
+    qint64 memorybudget = 0;
+    int waiting = 0;
+    bool batch = false;
+    bool processing = false;
+    double cpu = 0.0;
+    quint64 started = 0;  // jobs that left waiting, cumulative
+    quint64 finished = 0;  // jobs that left running, cumulative
+    qint64 waittime = 0;  // in milliseconds, cumulative
+    qint64 runtime = 0;
+    quint64 cachehits = 0;  // outputs restored from the cache, cumulative
+    quint64 cachemisses = 0;
+    quint64 skipped = 0;  // up-to-date jobs completed without running, cumulative
+    qint64 remaining = 0;  // in milliseconds, expected time until waiting and running jobs are done
+    QueueCounts jobs;
+    QHash<QUuid, QueueCounts> batches;
+    QHash<QString, QueueCounts> presets;
+};
+
 class QueuePrivate;
 class Queue : public QObject {
     Q_OBJECT
@@ -20,21 +67,50 @@ public:
     QUuid submit(QSharedPointer<Job> job, const QUuid& batch = QUuid());
     QList<QUuid> submit(const QList<QSharedPointer<Job>>& jobs, const QUuid& batch = QUuid());
     void start(const QUuid& uuid);
+    void start(const QList<QUuid>& uuids);
     void stop(const QUuid& uuid);
+    void stop(const QList<QUuid>& uuids);
+    void cancel(const QUuid& batch);
+    void setPriority(const QList<QUuid>& uuids, int priority);
     void restart(const QUuid& uuid);
     void restart(const QList<QUuid>& uuids);
     void remove(const QUuid& uuid);
     void remove(const QList<QUuid>& uuids);
+    QList<QUuid> restore();
     int threads() const;
     void setThreads(int threads);
+    bool isAdaptive() const;
+    void setAdaptive(bool adaptive);
+    int reserved() const;
+    void setReserved(int reserved);
     bool isBatch();
     bool isProcessing();
+    std::shared_ptr<const QueueSnapshot> snapshot() const;
+    double expectedDuration(const QString& preset, const QString& id, qint64 size) const;  // msecs, -1 if unknown
+    double durationPercentile(const QString& preset, const QString& id, double percentile) const;
+    QString scratchPath() const;
+
+    // non-blocking, completes on the queue thread
+    QFuture<void> beginBatchAsync(const QUuid& uuid, int chunks = 256);
+    QFuture<void> endBatchAsync(const QUuid& uuid);
+    QFuture<QList<QUuid>> submitAsync(const QList<QSharedPointer<Job>>& jobs, const QUuid& batch = QUuid());
+    QFuture<void> startAsync(const QList<QUuid>& uuids);
+    QFuture<void> stopAsync(const QList<QUuid>& uuids);
+    QFuture<void> cancelAsync(const QUuid& batch);
+    QFuture<void> setPriorityAsync(const QList<QUuid>& uuids, int priority);
+    QFuture<void> restartAsync(const QList<QUuid>& uuids);
+    QFuture<void> removeAsync(const QList<QUuid>& uuids);
+    QFuture<QList<QUuid>> restoreAsync();
+    QFuture<void> setThreadsAsync(int threads);
+    QFuture<void> setAdaptiveAsync(bool adaptive);
+    QFuture<void> setReservedAsync(int reserved);
 
 Q_SIGNALS:
     void batchSubmitted(const QList<QSharedPointer<Job>>& jobs);
     void jobsSubmitted(const QList<QSharedPointer<Job>>& jobs);
     void jobsProcessed(const QList<QUuid>& uuids);
     void jobsRemoved(const QList<QUuid>& uuids);
+    void concurrencyChanged(int concurrency, const QString& reason);
 
 private:
     Queue();
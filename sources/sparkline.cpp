@@ -0,0 +1,150 @@
+// Copyright 2022-present Contributors to the jobman project.
+// SPDX-License-Identifier: BSD-3-Clause
+// https://github.com/mikaelsundell/jobman
+
+#include "sparkline.h"
+
+#include <QPainter>
+#include <QPainterPath>
+#include <QPointer>
+
+class SparklinePrivate : public QObject {
+    Q_OBJECT
+public:
+    SparklinePrivate();
+    void init();
+
+public:
+    QString title;
+    QString text;
+    QList<qreal> values;
+    int samples;
+    QPointer<Sparkline> widget;
+};
+
+SparklinePrivate::SparklinePrivate()
+    : samples(60)
+{}
+
+void
+SparklinePrivate::init()
+{}
+
+#include "sparkline.moc"
+
+Sparkline::Sparkline(QWidget* parent)
+    : QWidget(parent)
+    , p(new SparklinePrivate())
+{
+    p->widget = this;
+    p->init();
+}
+
+Sparkline::~Sparkline() {}
+
+QString
+Sparkline::title() const
+{
+    return p->title;
+}
+
+QString
+Sparkline::text() const
+{
+    return p->text;
+}
+
+int
+Sparkline::samples() const
+{
+    return p->samples;
+}
+
+QSize
+Sparkline::sizeHint() const
+{
+    return QSize(120, 44);
+}
+
+void
+Sparkline::setTitle(const QString& title)
+{
+    p->title = title;
+    update();
+}
+
+void
+Sparkline::setText(const QString& text)
+{
+    p->text = text;
+    update();
+}
+
+void
+Sparkline::setSamples(int samples)
+{
+    p->samples = qMax(2, samples);
+    while (p->values.size() > p->samples) {
+        p->values.removeFirst();
+    }
+    update();
+}
+
+void
+Sparkline::addValue(qreal value)
+{
+    p->values.append(value);
+    if (p->values.size() > p->samples) {
+        p->values.removeFirst();
+    }
+    update();
+}
+
+void
+Sparkline::clear()
+{
+    p->values.clear();
+    p->text.clear();
+    update();
+}
+
+void
+Sparkline::paintEvent(QPaintEvent* event)
+{
+    Q_UNUSED(event);
+    QPainter painter(this);
+    painter.setRenderHint(QPainter::Antialiasing, true);
+    QFontMetrics metrics(font());
+    QRect rect = this->rect().adjusted(2, 2, -2, -2);
+    // labels
+    painter.setPen(palette().color(QPalette::PlaceholderText));
+    painter.drawText(rect, Qt::AlignLeft | Qt::AlignTop, p->title);
+    painter.setPen(palette().color(QPalette::Text));
+    painter.drawText(rect, Qt::AlignRight | Qt::AlignTop, p->text);
+    // line
+    QRectF graph = rect.adjusted(0, metrics.height() + 2, 0, 0);
+    if (p->values.size() < 2 || graph.height() <= 0) {
+        return;
+    }
+    qreal maximum = 0.0;
+    for (qreal value : p->values) {
+        maximum = qMax(maximum, value);
+    }
+    if (maximum <= 0.0) {
+        maximum = 1.0;  // flat line at the bottom
+    }
+    qreal step = graph.width() / (p->samples - 1);
+    qreal x = graph.right() - step * (p->values.size() - 1);  // newest sample to the right
+    QPainterPath path;
+    for (int i = 0; i < p->values.size(); ++i) {
+        QPointF point(x + step * i, graph.bottom() - graph.height() * p->values[i] / maximum);
+        if (i == 0) {
+            path.moveTo(point);
+        }
+        else {
+            path.lineTo(point);
+        }
+    }
+    painter.setPen(QPen(palette().color(QPalette::Highlight), 1.5));
+    painter.drawPath(path);
+}
@@ -0,0 +1,32 @@
+// Copyright 2022-present Contributors to the jobman project.
+// SPDX-License-Identifier: BSD-3-Clause
+// https://github.com/mikaelsundell/jobman
+
+#pragma once
+
+#include <QWidget>
+
+class SparklinePrivate;
+class Sparkline : public QWidget {
+    Q_OBJECT
+public:
+    Sparkline(QWidget* parent = nullptr);
+    virtual ~Sparkline();
+    QString title() const;
+    QString text() const;
+    int samples() const;
+    QSize sizeHint() const override;
+
+public Q_SLOTS:
+    void setTitle(const QString& title);
+    void setText(const QString& text);
+    void setSamples(int samples);
+    void addValue(qreal value);
+    void clear();
+
+protected:
+    void paintEvent(QPaintEvent* event) override;
+
+private:
+    QScopedPointer<SparklinePrivate> p;
+};
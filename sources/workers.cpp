@@ -0,0 +1,224 @@
+// Copyright 2022-present Contributors to the jobman project.
+// SPDX-License-Identifier: BSD-3-Clause
+// https://github.com/mikaelsundell/jobman
+
+#include "workers.h"
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMutex>
+#include <QPointer>
+
+class WorkersPrivate : public QObject {
+    Q_OBJECT
+public:
+    WorkersPrivate();
+    void init();
+    QString key(const QString& command, const QSharedPointer<Job>& job, const QString& startin,
+                const QList<QPair<QString, QString>>& environmentvars) const;
+    void stop(const QList<QSharedPointer<Process>>& processes);
+
+public:
+    struct Entry {
+        QSharedPointer<Process> process;
+        QString key;
+        int jobs;
+        qint64 released;
+        bool crashed;
+    };
+    QList<Entry> idle;
+    QHash<Process*, Entry> busy;
+    QElapsedTimer clock;
+    mutable QMutex mutex;  // guards idle and busy, never held while starting or stopping processes
+    QPointer<Workers> object;
+};
+
+WorkersPrivate::WorkersPrivate() {}
+
+void
+WorkersPrivate::init()
+{
+    clock.start();
+}
+
+QString
+WorkersPrivate::key(const QString& command, const QSharedPointer<Job>& job, const QString& startin,
+                    const QList<QPair<QString, QString>>& environmentvars) const
+{
+    // workers are shared by jobs started the same way, requests carry everything else
+    QStringList values { command, startin };
+    values.append(job->worker().arguments);
+    for (const QPair<QString, QString>& environmentvar : environmentvars) {
+        values.append(QString("%1=%2").arg(environmentvar.first).arg(environmentvar.second));
+    }
+    return values.join(QChar('\0'));
+}
+
+void
+WorkersPrivate::stop(const QList<QSharedPointer<Process>>& processes)
+{
+    for (const QSharedPointer<Process>& process : processes) {
+        process->kill();  // requests are the unit of work, nothing is lost between them
+    }
+}
+
+#include "workers.moc"
+
+Workers::Workers(QObject* parent)
+    : QObject(parent)
+    , p(new WorkersPrivate())
+{
+    p->object = this;
+    p->init();
+}
+
+Workers::~Workers() { clear(); }
+
+int
+Workers::count() const
+{
+    QMutexLocker locker(&p->mutex);
+    return p->idle.size() + p->busy.size();
+}
+
+int
+Workers::served(const QSharedPointer<Process>& process) const
+{
+    QMutexLocker locker(&p->mutex);  // jobs completed by a busy worker before the current one
+    auto it = p->busy.constFind(process.data());
+    return it != p->busy.constEnd() ? it->jobs : 0;
+}
+
+QSharedPointer<Process>
+Workers::acquire(const QString& command, const QSharedPointer<Job>& job, const QString& startin,
+                 const QList<QPair<QString, QString>>& environmentvars)
+{
+    // slot and thread variables expanded by the queue, a new thread budget or jobserver starts new workers
+    const QString key = p->key(command, job, startin, environmentvars);
+    QSharedPointer<Process> process;
+    QList<QSharedPointer<Process>> exited;
+    {
+        QMutexLocker locker(&p->mutex);
+        for (int i = p->idle.size() - 1; i >= 0 && !process; --i) {
+            if (p->idle[i].key != key) {
+                continue;
+            }
+            WorkersPrivate::Entry entry = p->idle.takeAt(i);  // most recent first, older ones expire
+            if (!entry.process->isRunning()) {
+                exited.append(entry.process);  // crashed while idle
+                continue;
+            }
+            process = entry.process;
+            p->busy.insert(process.data(), entry);
+        }
+    }
+    p->stop(exited);
+    if (!process) {
+        process.reset(new Process());
+        process->start(command, job->worker().arguments, startin, environmentvars);
+        QMutexLocker locker(&p->mutex);
+        p->busy.insert(process.data(), WorkersPrivate::Entry { process, key, 0, 0, false });
+    }
+    return process;
+}
+
+bool
+Workers::request(const QSharedPointer<Process>& process, const QSharedPointer<Job>& job, const QStringList& arguments,
+                 const QString& startin, QString& standardoutput, QString& standarderror, int& exitcode)
+{
+    // one json object per line each way, lines before the response are command output
+    QJsonObject object;
+    object["uuid"] = job->uuid().toString(QUuid::WithoutBraces);
+    object["id"] = job->id();
+    object["arguments"] = QJsonArray::fromStringList(arguments);
+    object["startin"] = startin;
+    object["dir"] = job->dir();
+    object["output"] = job->output();
+    bool responded = false;
+    QByteArray line;
+    QByteArray error;
+    if (process->write(QJsonDocument(object).toJson(QJsonDocument::Compact) + '\n')) {
+        while (process->readLine(line, error)) {
+            QJsonParseError parseerror;
+            const QJsonDocument document = QJsonDocument::fromJson(line, &parseerror);
+            if (parseerror.error == QJsonParseError::NoError && document.isObject()
+                && document.object().contains("status")) {
+                const QJsonObject response = document.object();
+                exitcode = response["status"].toInt(1);
+                standardoutput += response["output"].toString();
+                standarderror += response["error"].toString();
+                responded = true;
+                break;
+            }
+            standardoutput += QString::fromLocal8Bit(line) + "\n";
+        }
+    }
+    standarderror.prepend(QString::fromLocal8Bit(error));
+    if (!responded) {
+        process->wait();  // reaps the worker for its exit code
+        standardoutput += process->standardOutput();
+        standarderror += process->standardError();
+        standarderror += "Worker exited without a response\n";
+        exitcode = process->exitCode() != 0 ? process->exitCode() : -1;
+        QMutexLocker locker(&p->mutex);
+        auto it = p->busy.find(process.data());
+        if (it != p->busy.end()) {
+            it->crashed = true;
+        }
+    }
+    return responded && exitcode == 0;
+}
+
+void
+Workers::release(const QSharedPointer<Process>& process, const QSharedPointer<Job>& job)
+{
+    {
+        QMutexLocker locker(&p->mutex);
+        auto it = p->busy.find(process.data());
+        if (it == p->busy.end()) {
+            return;
+        }
+        WorkersPrivate::Entry entry = it.value();
+        p->busy.erase(it);
+        entry.jobs++;
+        if (!entry.crashed && entry.jobs < job->worker().jobs && process->isRunning()) {
+            entry.released = p->clock.elapsed();
+            p->idle.append(entry);
+            return;
+        }
+    }
+    p->stop({ process });  // recycled after its jobs, leaks in long lived tools stay bounded
+}
+
+void
+Workers::expire(qint64 milliseconds)
+{
+    QList<QSharedPointer<Process>> expired;
+    {
+        QMutexLocker locker(&p->mutex);
+        const qint64 now = p->clock.elapsed();
+        for (int i = p->idle.size() - 1; i >= 0; --i) {
+            if (now - p->idle[i].released > milliseconds) {
+                expired.append(p->idle.takeAt(i).process);
+            }
+        }
+    }
+    p->stop(expired);
+}
+
+void
+Workers::clear()
+{
+    QList<QSharedPointer<Process>> processes;
+    {
+        QMutexLocker locker(&p->mutex);
+        for (const WorkersPrivate::Entry& entry : p->idle) {
+            processes.append(entry.process);
+        }
+        p->idle.clear();
+    }
+    p->stop(processes);  // busy workers are killed with their jobs
+}
@@ -0,0 +1,31 @@
+// Copyright 2022-present Contributors to the jobman project.
+// SPDX-License-Identifier: BSD-3-Clause
+// https://github.com/mikaelsundell/jobman
+
+#pragma once
+
+#include "job.h"
+#include "process.h"
+
+#include <QObject>
+#include <QSharedPointer>
+
+class WorkersPrivate;
+class Workers : public QObject {
+    Q_OBJECT
+public:
+    Workers(QObject* parent = nullptr);
+    virtual ~Workers();
+    int count() const;
+    int served(const QSharedPointer<Process>& process) const;
+    QSharedPointer<Process> acquire(const QString& command, const QSharedPointer<Job>& job, const QString& startin,
+                                    const QList<QPair<QString, QString>>& environmentvars);
+    bool request(const QSharedPointer<Process>& process, const QSharedPointer<Job>& job, const QStringList& arguments,
+                 const QString& startin, QString& standardoutput, QString& standarderror, int& exitcode);
+    void release(const QSharedPointer<Process>& process, const QSharedPointer<Job>& job);
+    void expire(qint64 milliseconds);
+    void clear();
+
+private:
+    QScopedPointer<WorkersPrivate> p;
+};